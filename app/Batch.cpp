@@ -5,6 +5,8 @@
 // ospray_sg
 #include "sg/Frame.h"
 #include "sg/fb/FrameBuffer.h"
+#include "sg/exporter/ExportQueue.h"
+#include "sg/exporter/ImageExporter.h"
 #include "sg/renderer/MaterialRegistry.h"
 #include "sg/visitors/Commit.h"
 #include "sg/visitors/PrintNodes.h"
@@ -102,6 +104,9 @@ void BatchContext::start()
       }
     }
 
+    savePendingFrame();
+    sg::flushExports();
+
     std::cout << "...finished!" << std::endl;
     sg::clearAssets();
   }
@@ -214,6 +219,11 @@ void BatchContext::addToCommandLine (std::shared_ptr<CLI::App> app) {
     saveScene,
     "Saves the SceneGraph representing the frame"
   );
+  app->add_option(
+    "--tileSize",
+    optTileSize,
+    "Render and save images in tiles of this size, for large resolutions"
+  )->check(CLI::PositiveNumber);
 }
 //}}}
 //{{{
@@ -385,26 +395,13 @@ void BatchContext::renderFrame()
     frame->denoiseFB = true;
     frame->denoiseFBFinalFrame = true;
   }
-  frame->immediatelyWait = true;
 
-  auto &fb = frame->childAs<sg::FrameBuffer>("framebuffer");
-  auto &v = frame->childAs<sg::Renderer>("renderer")["varianceThreshold"];
-  auto varianceThreshold = v.valueAs<float>();
-  float fbVariance{inf};
-
-  // continue accumulation till variance threshold or accumulation limit is
-  // reached
-  do {
-    frame->startNewFrame();
-    fbVariance = fb.variance();
-    std::cout << "frame " << frame->currentAccum << " ";
-    std::cout << "variance " << fbVariance << std::endl;
-  } while (fbVariance >= varianceThreshold && !frame->accumLimitReached());
+  // Tiles are rendered while the image is saved, by the only rank
+  const bool tiled = optTileSize > 0 && !sgUsingMpi();
+  frame->pipelined = optPipelined && !tiled;
 
-  if (frame->denoiseFB) {
-    std::cout << "denoising..." << std::endl;
-    frame->startNewFrame();
-  }
+  if (!tiled)
+    accumulateFrame();
 
   static int filenum;
   if (resetFileId) {
@@ -431,9 +428,16 @@ void BatchContext::renderFrame()
     int screenshotFlags = optSaveLayersSeparately << 3 | optSaveNormal << 2
         | optSaveDepth << 1 | optSaveAlbedo;
 
-    frame->saveFrame(filename, screenshotFlags);
-
-    this->outputFilename = filename;
+    if (frame->pipelined) {
+      pendingFilename = filename;
+      pendingFlags = screenshotFlags;
+    } else {
+      if (tiled)
+        renderTiledFrame(filename, screenshotFlags);
+      else
+        frame->saveFrame(filename, screenshotFlags);
+      this->outputFilename = filename;
+    }
 
     if (saveScene)
     {
@@ -458,6 +462,175 @@ void BatchContext::renderFrame()
     }
   }
 
+  if (pendingFilename.empty())
+    pluginManager->main(shared_from_this());
+}
+//}}}
+//{{{
+void BatchContext::accumulateFrame()
+{
+  auto &fb = frame->childAs<sg::FrameBuffer>("framebuffer");
+  auto &v = frame->childAs<sg::Renderer>("renderer")["varianceThreshold"];
+  auto varianceThreshold = v.valueAs<float>();
+  float fbVariance{inf};
+
+  // The previous image is saved while the first pass of this one renders
+  frame->immediatelyWait = pendingFilename.empty();
+
+  // continue accumulation till variance threshold or accumulation limit is
+  // reached
+  do {
+    frame->startNewFrame();
+    if (!frame->immediatelyWait) {
+      savePendingFrame();
+      frame->waitOnFrame();
+      frame->immediatelyWait = true;
+    }
+    fbVariance = fb.variance();
+    std::cout << "frame " << frame->currentAccum << " ";
+    std::cout << "variance " << fbVariance << std::endl;
+  } while (fbVariance >= varianceThreshold && !frame->accumLimitReached());
+
+  if (frame->denoiseFB) {
+    std::cout << "denoising..." << std::endl;
+    frame->startNewFrame();
+  }
+}
+//}}}
+//{{{
+void BatchContext::renderTiledFrame(const std::string &filename, int flags)
+{
+  auto &fb = frame->childAs<sg::FrameBuffer>("framebuffer");
+  auto &camera = frame->child("camera");
+  const vec2i imageSize = frame->child("windowSize").valueAs<vec2i>();
+  const auto colorFormat = fb.child("colorFormat").valueAs<std::string>();
+  auto file = rkcommon::FileName(filename);
+
+  // Layers only go into streamed EXR images
+  const bool exr = file.ext() == "exr";
+  const bool albedo = exr && (flags & 0b1) && fb.hasAlbedoChannel();
+  const bool depth = exr && (flags & 0b10) && fb.hasDepthChannel();
+  const bool normal = exr && (flags & 0b100) && fb.hasNormalChannel();
+  if ((flags & 0b111) && !exr)
+    std::cout << "Tiled rendering only saves layers into .exr images"
+              << std::endl;
+
+  std::shared_ptr<sg::ImageExporter> exp;
+  auto exporter = sg::getExporter(file);
+  if (exporter != "") {
+    exp = sg::createNodeAs<sg::ImageExporter>("exporter", exporter);
+    exp->child("file") = filename;
+    exp->setImageData(nullptr, imageSize, colorFormat);
+    if (albedo)
+      exp->setAdditionalLayer("albedo", nullptr);
+    if (depth)
+      exp->setAdditionalLayer("Z", nullptr);
+    if (normal)
+      exp->setAdditionalLayer("normal", nullptr);
+    exp->createChild("layersAsSeparateFiles", "bool", bool(flags & 0b1000));
+  }
+
+  if (!exp || !exp->beginStream()) {
+    std::cout << "Can't stream ." << file.ext()
+              << " images, rendering the whole image at once" << std::endl;
+    accumulateFrame();
+    frame->saveFrame(filename, flags);
+    return;
+  }
+
+  const vec2f imageStart = camera["imageStart"].valueAs<vec2f>();
+  const vec2f imageEnd = camera["imageEnd"].valueAs<vec2f>();
+  const vec2i tileSize(
+      std::min(optTileSize, imageSize.x), std::min(optTileSize, imageSize.y));
+  const size_t bandPixels = size_t(imageSize.x) * tileSize.y;
+
+  // A band of full rows, top down like the file, filled tile by tile
+  std::vector<uint8_t> band(
+      bandPixels * (colorFormat == "float" ? sizeof(vec4f) : sizeof(vec4uc)));
+  std::vector<vec3f> albedoBand(albedo ? bandPixels : 0);
+  std::vector<float> depthBand(depth ? bandPixels : 0);
+  std::vector<vec3f> normalBand(normal ? bandPixels : 0);
+
+  // Tiles denoised on their own would show seams, so when denoising each is
+  // rendered with a border of about half the denoiser's receptive field,
+  // which is cropped again
+  const int border = frame->denoiseFB ? 96 : 0;
+
+  bool saved = true;
+  for (int top = imageSize.y; top > 0 && saved; top -= tileSize.y) {
+    const int bottom = std::max(0, top - tileSize.y);
+    for (int left = 0; left < imageSize.x; left += tileSize.x) {
+      const int right = std::min(imageSize.x, left + tileSize.x);
+      const vec2i size(right - left, top - bottom);
+      std::cout << "tile [" << left << ", " << bottom << "]-[" << right << ", "
+                << top << "]" << std::endl;
+
+      const vec2i renderLower(
+          std::max(0, left - border), std::max(0, bottom - border));
+      const vec2i renderUpper(std::min(imageSize.x, right + border),
+          std::min(imageSize.y, top + border));
+      const vec2i renderSize = renderUpper - renderLower;
+
+      // Each tile accumulates on its own, in a tile sized framebuffer
+      frame->child("windowSize") = renderSize;
+      camera["imageStart"] = imageStart
+          + (imageEnd - imageStart) * vec2f(renderLower) / vec2f(imageSize);
+      camera["imageEnd"] = imageStart
+          + (imageEnd - imageStart) * vec2f(renderUpper) / vec2f(imageSize);
+      accumulateFrame();
+
+      auto copyTile =
+          [&](void *dst, OSPFrameBufferChannel channel, size_t pixelBytes) {
+            auto *src = (const uint8_t *)frame->mapFrame(channel);
+            // framebuffer rows are bottom up
+            for (int y = 0; y < size.y; y++) {
+              const size_t srcRow = top - 1 - y - renderLower.y;
+              std::memcpy((uint8_t *)dst
+                      + (size_t(y) * imageSize.x + left) * pixelBytes,
+                  src
+                      + (srcRow * renderSize.x + left - renderLower.x)
+                          * pixelBytes,
+                  size.x * pixelBytes);
+            }
+            frame->unmapFrame((void *)src);
+          };
+
+      copyTile(band.data(), OSP_FB_COLOR, band.size() / bandPixels);
+      if (albedo)
+        copyTile(albedoBand.data(), OSP_FB_ALBEDO, sizeof(vec3f));
+      if (depth)
+        copyTile(depthBand.data(), OSP_FB_DEPTH, sizeof(float));
+      if (normal)
+        copyTile(normalBand.data(), OSP_FB_NORMAL, sizeof(vec3f));
+    }
+
+    if (albedo)
+      exp->setAdditionalLayer("albedo", albedoBand.data());
+    if (depth)
+      exp->setAdditionalLayer("Z", depthBand.data());
+    if (normal)
+      exp->setAdditionalLayer("normal", normalBand.data());
+    saved = exp->writeRows(band.data(), top - bottom);
+  }
+
+  if (!exp->endStream() || !saved)
+    std::cerr << "Could not save " << filename << std::endl;
+
+  frame->child("windowSize") = imageSize;
+  camera["imageStart"] = imageStart;
+  camera["imageEnd"] = imageEnd;
+}
+//}}}
+//{{{
+void BatchContext::savePendingFrame()
+{
+  if (pendingFilename.empty())
+    return;
+
+  frame->saveFrame(pendingFilename, pendingFlags);
+  this->outputFilename = pendingFilename;
+  pendingFilename.clear();
+
   pluginManager->main(shared_from_this());
 }
 //}}}
@@ -32,6 +32,9 @@ class BatchContext : public StudioContext
   void renderAnimation();
   void refreshCamera(int cameraIdx);
   void reshape();
+  void savePendingFrame();
+  void accumulateFrame();
+  void renderTiledFrame(const std::string &filename, int flags);
 
  protected:
   NodePtr importedModels;
@@ -43,6 +46,7 @@ class BatchContext : public StudioContext
   bool forceRewrite{false};
   range1i framesRange{0, -1}; // empty
   int frameStep{1};
+  int optTileSize{0}; // 0 renders whole images
   range1i cameraRange{0, 0};
 
   // list of cameras imported with the scene definition
@@ -58,4 +62,8 @@ class BatchContext : public StudioContext
 
   // SceneGraph
   bool saveScene{false};
+
+  // Pipelined, each image is saved once the next one started rendering
+  std::string pendingFilename;
+  int pendingFlags{0};
 };
@@ -9,10 +9,13 @@
 #include "Proggy.h"
 // std
 #include <chrono>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <type_traits>
 // ospray_sg
 #include "sg/camera/Camera.h"
+#include "sg/exporter/ExportQueue.h"
 #include "sg/exporter/Exporter.h"
 #include "sg/fb/FrameBuffer.h"
 #include "sg/generator/Generator.h"
@@ -28,6 +31,7 @@
 #include "sg/Math.h"
 // rkcommon
 #include "rkcommon/math/rkmath.h"
+#include "rkcommon/tasking/parallel_for.h"
 #include "rkcommon/os/FileName.h"
 #include "rkcommon/utility/SaveImage.h"
 #include "rkcommon/utility/getEnvVar.h"
@@ -124,6 +128,101 @@ float lockAspectRatio = 0.0;
 
 sg::NodePtr g_copiedMat = nullptr;
 
+//{{{
+// Frame preview kernels.  They stage a mapped OSPRay channel for display,
+// in parallel blocks, with branch-free inner loops the compiler vectorizes.
+static const size_t previewBlockSize = 1 << 16; // elements
+
+static size_t previewBlocks(size_t numElements)
+{
+  return (numElements + previewBlockSize - 1) / previewBlockSize;
+}
+
+// Color and albedo are displayed as they are
+static void previewCopy(void *dst, const void *src, size_t numBytes)
+{
+  auto *d = static_cast<uint8_t *>(dst);
+  const auto *s = static_cast<const uint8_t *>(src);
+  rkcommon::tasking::parallel_for(previewBlocks(numBytes), [&](size_t b) {
+    const size_t begin = b * previewBlockSize;
+    const size_t end = std::min(begin + previewBlockSize, numBytes);
+    std::memcpy(d + begin, s + begin, end - begin);
+  });
+}
+
+// Scales OSPRay's 0 -> inf depth range to OpenGL 0 -> 1 (or 1 -> 0 if
+// inverted, which may be more meaningful), over the finite depths.  The
+// range is reduced per block first, then the scaling is a single
+// multiply-add per pixel.
+static void previewDepth(
+    float *dst, const float *src, size_t numPixels, bool invert)
+{
+  // Depths aren't negative, so their bits compare like the values.  As ints
+  // the reduction vectorizes, floats would need fast-math.
+  const int32_t infBits = 0x7f800000;
+  static std::vector<std::pair<int32_t, int32_t>> blockRanges; // reused
+  const size_t numBlocks = previewBlocks(numPixels);
+  blockRanges.resize(numBlocks);
+
+  rkcommon::tasking::parallel_for(numBlocks, [&](size_t b) {
+    const size_t begin = b * previewBlockSize;
+    const size_t end = std::min(begin + previewBlockSize, numPixels);
+    int32_t lo = infBits;
+    int32_t hi = -1;
+    for (size_t i = begin; i < end; i++) {
+      int32_t bits;
+      std::memcpy(&bits, src + i, sizeof(bits));
+      bits = bits < 0 ? 0 : bits;
+      const int32_t finite = bits < infBits ? bits : -1;
+      lo = bits < lo ? bits : lo;
+      hi = finite > hi ? finite : hi;
+    }
+    blockRanges[b] = std::make_pair(lo, hi);
+  });
+
+  int32_t lo = infBits;
+  int32_t hi = -1;
+  for (auto &range : blockRanges) {
+    lo = std::min(lo, range.first);
+    hi = std::max(hi, range.second);
+  }
+
+  // depth * scale + offset, infinite depth saturates
+  float scale = 1.f;
+  float offset = 0.f;
+  if (hi >= 0) {
+    float minDepth, maxDepth;
+    std::memcpy(&minDepth, &lo, sizeof(minDepth));
+    std::memcpy(&maxDepth, &hi, sizeof(maxDepth));
+    scale = 1.f / (maxDepth - minDepth);
+    offset = -minDepth * scale;
+  }
+  if (invert) {
+    scale = -scale;
+    offset = 1.f - offset;
+  }
+
+  rkcommon::tasking::parallel_for(numBlocks, [&](size_t b) {
+    const size_t begin = b * previewBlockSize;
+    const size_t end = std::min(begin + previewBlockSize, numPixels);
+    for (size_t i = begin; i < end; i++)
+      dst[i] = src[i] * scale + offset;
+  });
+}
+
+// Maps normals from -1 -> 1 to 0 -> 1 per component
+static void previewNormal(float *dst, const float *src, size_t numPixels)
+{
+  const size_t numFloats = 3 * numPixels;
+  rkcommon::tasking::parallel_for(previewBlocks(numFloats), [&](size_t b) {
+    const size_t begin = b * previewBlockSize;
+    const size_t end = std::min(begin + previewBlockSize, numFloats);
+    for (size_t i = begin; i < end; i++)
+      dst[i] = src[i] * 0.5f + 0.5f;
+  });
+}
+//}}}
+
 //{{{
 std::string quatToString(quaternionf &q)
 {
@@ -450,6 +549,7 @@ MainWindow::MainWindow(StudioCommon &_common)
   glBindTexture(GL_TEXTURE_2D, framebufferTexture);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  initFramebufferUpload();
 
   refreshScene(true);
 
@@ -461,9 +561,12 @@ MainWindow::MainWindow(StudioCommon &_common)
 //{{{
 MainWindow::~MainWindow()
 {
+  sg::flushExports();
   ImGui_ImplOpenGL2_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
+  if (pixelBuffers[0])
+    glPBO.deleteBuffers(2, pixelBuffers);
   glfwTerminate();
   pluginManager->removeAllPlugins();
   g_sceneCameras.clear();
@@ -975,7 +1078,27 @@ void MainWindow::display()
   fbSize = frameBuffer.child("size").valueAs<vec2i>();
 
   if (frame->frameIsReady()) {
-    if (!frame->isCanceled()) {
+    auto readyTime = std::chrono::high_resolution_clock::now();
+    bool newImage = false;
+    GLenum glInternalFormat = gl_rgba_format;
+    GLenum glFormat = GL_RGBA;
+    GLenum glType = GL_UNSIGNED_BYTE;
+
+    // Start new frame and reset frame timing interval start
+    auto startNextFrame = [&]() {
+      displayStart = std::chrono::high_resolution_clock::now();
+      latestDisplayLatency =
+          std::chrono::duration<float, std::milli>(displayStart - readyTime)
+              .count();
+      startNewOSPRayFrame();
+    };
+
+    // A pipelined frame restarting accumulation renders into the other
+    // framebuffer, so it can start before this one is staged
+    const bool completed = !frame->isCanceled();
+    const bool renderAhead = frame->pipelined && frame->isModified();
+
+    if (completed) {
       // display frame rate in window title
       auto displayEnd = std::chrono::high_resolution_clock::now();
       auto durationMilliseconds =
@@ -983,71 +1106,57 @@ void MainWindow::display()
               displayEnd - displayStart);
 
       latestFPS = 1000.f / float(durationMilliseconds.count());
+    }
 
-      // map OSPRay framebuffer, update OpenGL texture with contents, then unmap
-      waitOnOSPRayFrame();
+    if (renderAhead)
+      startNextFrame();
+
+    if (completed) {
+      // map OSPRay framebuffer, stage its contents for the OpenGL texture,
+      // then unmap
+      if (!renderAhead)
+        waitOnOSPRayFrame();
 
       // Only enabled if they exist
       optShowAlbedo &= frameBuffer.hasAlbedoChannel();
       optShowDepth &= frameBuffer.hasDepthChannel();
-
-      auto *mappedFB = (void *)frame->mapFrame(optShowDepth
-              ? OSP_FB_DEPTH
-              : (optShowAlbedo ? OSP_FB_ALBEDO : OSP_FB_COLOR));
-
-      // This needs to query the actual framebuffer format
-      const GLenum glType =
-          frameBuffer.isFloatFormat() ? GL_FLOAT : GL_UNSIGNED_BYTE;
-
-      // Only create the copy if it's needed
-      float *pDepthCopy = nullptr;
-      if (optShowDepth) {
-        // Create a local copy and don't modify OSPRay buffer
-        const auto *mappedDepth = static_cast<const float *>(mappedFB);
-        std::vector<float> depthCopy(
-            mappedDepth, mappedDepth + fbSize.x * fbSize.y);
-        pDepthCopy = depthCopy.data();
-
-        // Scale OSPRay's 0 -> inf depth range to OpenGL 0 -> 1, ignoring all
-        // inf values
-        float minDepth = rkcommon::math::inf;
-        float maxDepth = rkcommon::math::neg_inf;
-        for (auto depth : depthCopy) {
-          if (isinf(depth))
-            continue;
-          minDepth = std::min(minDepth, depth);
-          maxDepth = std::max(maxDepth, depth);
-        }
-
-        const float rcpDepthRange = 1.f / (maxDepth - minDepth);
-
-        // Inverted depth (1.0 -> 0.0) may be more meaningful
-        if (optShowDepthInvert)
-          std::transform(depthCopy.begin(),
-              depthCopy.end(),
-              depthCopy.begin(),
-              [&](float depth) {
-                return (1.f - (depth - minDepth) * rcpDepthRange);
-              });
-        else
-          std::transform(depthCopy.begin(),
-              depthCopy.end(),
-              depthCopy.begin(),
-              [&](float depth) { return (depth - minDepth) * rcpDepthRange; });
-      }
-
-      glBindTexture(GL_TEXTURE_2D, framebufferTexture);
-      glTexImage2D(GL_TEXTURE_2D,
-          0,
-          optShowAlbedo ? gl_rgb_format : gl_rgba_format,
-          fbSize.x,
-          fbSize.y,
-          0,
-          optShowDepth ? GL_LUMINANCE : (optShowAlbedo ? GL_RGB : GL_RGBA),
-          glType,
-          optShowDepth ? pDepthCopy : mappedFB);
+      optShowNormal &= frameBuffer.hasNormalChannel();
+
+      const OSPFrameBufferChannel channel = optShowDepth
+          ? OSP_FB_DEPTH
+          : (optShowAlbedo ? OSP_FB_ALBEDO
+                           : (optShowNormal ? OSP_FB_NORMAL : OSP_FB_COLOR));
+      auto *mappedFB = (void *)frame->mapFrame(channel);
+
+      // Only color depends on the format, the other channels are float
+      const bool rgb = channel == OSP_FB_ALBEDO || channel == OSP_FB_NORMAL;
+      glInternalFormat = rgb ? gl_rgb_format : gl_rgba_format;
+      glFormat = optShowDepth ? GL_LUMINANCE : (rgb ? GL_RGB : GL_RGBA);
+      glType = (channel != OSP_FB_COLOR || frameBuffer.isFloatFormat())
+          ? GL_FLOAT
+          : GL_UNSIGNED_BYTE;
+
+      const size_t numPixels = size_t(fbSize.x) * fbSize.y;
+      const size_t numChannels = optShowDepth ? 1 : (rgb ? 3 : 4);
+      const size_t numBytes = numPixels * numChannels
+          * (glType == GL_FLOAT ? sizeof(float) : sizeof(uint8_t));
+
+      // Don't modify OSPRay buffer, the displayed version goes to staging
+      void *staging = beginFramebufferUpload(numBytes);
+      if (optShowDepth)
+        previewDepth(static_cast<float *>(staging),
+            static_cast<const float *>(mappedFB),
+            numPixels,
+            optShowDepthInvert);
+      else if (optShowNormal)
+        previewNormal(static_cast<float *>(staging),
+            static_cast<const float *>(mappedFB),
+            numPixels);
+      else
+        previewCopy(staging, mappedFB, numBytes);
 
       frame->unmapFrame(mappedFB);
+      newImage = true;
 
       // save frame to a file, if requested
       if (g_saveNextFrame) {
@@ -1056,9 +1165,13 @@ void MainWindow::display()
       }
     }
 
-    // Start new frame and reset frame timing interval start
-    displayStart = std::chrono::high_resolution_clock::now();
-    startNewOSPRayFrame();
+    if (!renderAhead)
+      startNextFrame();
+
+    // The staged frame doesn't need OSPRay's buffer, upload it while the next
+    // one renders
+    if (newImage)
+      endFramebufferUpload(glInternalFormat, glFormat, glType);
   }
 
   // Allow OpenGL to show linear buffers as sRGB.
@@ -1143,6 +1256,88 @@ void MainWindow::waitOnOSPRayFrame()
 }
 //}}}
 //{{{
+void MainWindow::initFramebufferUpload()
+{
+  const int major = glfwGetWindowAttrib(glfwWindow, GLFW_CONTEXT_VERSION_MAJOR);
+  const int minor = glfwGetWindowAttrib(glfwWindow, GLFW_CONTEXT_VERSION_MINOR);
+  if ((major < 2 || (major == 2 && minor < 1))
+      && !glfwExtensionSupported("GL_ARB_pixel_buffer_object"))
+    return;
+
+  auto load = [](auto &fn, const char *name) {
+    fn = reinterpret_cast<std::remove_reference_t<decltype(fn)>>(
+        glfwGetProcAddress(name));
+    return fn != nullptr;
+  };
+
+  if (load(glPBO.genBuffers, "glGenBuffers")
+      && load(glPBO.deleteBuffers, "glDeleteBuffers")
+      && load(glPBO.bindBuffer, "glBindBuffer")
+      && load(glPBO.bufferData, "glBufferData")
+      && load(glPBO.mapBuffer, "glMapBuffer")
+      && load(glPBO.unmapBuffer, "glUnmapBuffer"))
+    glPBO.genBuffers(2, pixelBuffers);
+}
+//}}}
+//{{{
+void *MainWindow::beginFramebufferUpload(size_t numBytes)
+{
+  pixelBufferMapped = false;
+
+  if (pixelBuffers[0]) {
+    pixelBufferIndex = 1 - pixelBufferIndex;
+    glPBO.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[pixelBufferIndex]);
+    // Reallocating lets the driver hand out fresh memory instead of waiting
+    // for a transfer still reading the old one
+    glPBO.bufferData(GL_PIXEL_UNPACK_BUFFER, numBytes, nullptr, GL_STREAM_DRAW);
+    void *mem = glPBO.mapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    glPBO.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (mem) {
+      pixelBufferMapped = true;
+      return mem;
+    }
+  }
+
+  stagingFrame.resize(numBytes);
+  return stagingFrame.data();
+}
+//}}}
+//{{{
+void MainWindow::endFramebufferUpload(
+    GLenum internalFormat, GLenum format, GLenum type)
+{
+  // Pixels are read from the bound buffer, at offset 0, if any
+  const void *pixels = stagingFrame.data();
+  if (pixelBufferMapped) {
+    glPBO.bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[pixelBufferIndex]);
+    glPBO.unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    pixels = nullptr;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, framebufferTexture);
+  if (fbSize != framebufferTextureSize
+      || internalFormat != framebufferTextureFormat) {
+    glTexImage2D(GL_TEXTURE_2D,
+        0,
+        internalFormat,
+        fbSize.x,
+        fbSize.y,
+        0,
+        format,
+        type,
+        pixels);
+    framebufferTextureSize = fbSize;
+    framebufferTextureFormat = internalFormat;
+  } else
+    glTexSubImage2D(
+        GL_TEXTURE_2D, 0, 0, 0, fbSize.x, fbSize.y, format, type, pixels);
+
+  if (pixelBufferMapped)
+    glPBO.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+//}}}
+//{{{
 void MainWindow::updateTitleBar()
 {
   std::stringstream windowTitle;
@@ -1263,6 +1458,8 @@ void MainWindow::refreshScene(bool resetCam)
 {
   if (frameAccumLimit)
     frame->accumLimit = frameAccumLimit;
+  if (optPipelined)
+    frame->pipelined = true;
   // Check that the frame contains a world, if not create one
   auto world = frame->hasChild("world") ? frame->childNodeAs<sg::Node>("world")
                                         : sg::createNode("world", "world");
@@ -1763,6 +1960,8 @@ void MainWindow::buildMainMenuView()
 
     ImGui::Checkbox("Rendering stats", &showRenderingStats);
     ImGui::Checkbox("Pause rendering", &frame->pauseRendering);
+    ImGui::Checkbox("Pipelined rendering", &frame->pipelined);
+    sg::showTooltip("Start the next frame while the last one is displayed");
     ImGui::SetNextItemWidth(5 * ImGui::GetFontSize());
     ImGui::DragInt(
         "Limit accumulation", &frame->accumLimit, 1, 0, INT_MAX, "%d frames");
@@ -2034,24 +2233,32 @@ void MainWindow::buildWindowFrameBufferEditor()
     ImGui::SameLine();
     ImGui::RadioButton("invert depth##displayDepthInv", &whichBuffer, 3);
   }
+  if (fb.hasNormalChannel()) {
+    ImGui::SameLine();
+    ImGui::RadioButton("normal##displayNormal", &whichBuffer, 4);
+  }
 
   switch (whichBuffer) {
   case 0:
     optShowColor = true;
-    optShowAlbedo = optShowDepth = optShowDepthInvert = false;
+    optShowAlbedo = optShowDepth = optShowDepthInvert = optShowNormal = false;
     break;
   case 1:
     optShowAlbedo = true;
-    optShowColor = optShowDepth = optShowDepthInvert = false;
+    optShowColor = optShowDepth = optShowDepthInvert = optShowNormal = false;
     break;
   case 2:
     optShowDepth = true;
-    optShowColor = optShowAlbedo = optShowDepthInvert = false;
+    optShowColor = optShowAlbedo = optShowDepthInvert = optShowNormal = false;
     break;
   case 3:
     optShowDepth = true;
     optShowDepthInvert = true;
-    optShowColor = optShowAlbedo = false;
+    optShowColor = optShowAlbedo = optShowNormal = false;
+    break;
+  case 4:
+    optShowNormal = true;
+    optShowColor = optShowAlbedo = optShowDepth = optShowDepthInvert = false;
     break;
   }
 
@@ -2141,6 +2348,22 @@ void MainWindow::buildWindowFrameBufferEditor()
         frame->child("scaleNav") = newScale;
       ImGui::EndCombo();
     }
+
+    auto &dynamicResolution = frame->dynamicResolution;
+    ImGui::Checkbox("Dynamic nav resolution", &dynamicResolution.enabled);
+    sg::showTooltip("Scale resolution while navigating to keep the frame rate");
+    if (dynamicResolution.enabled) {
+      ImGui::SetNextItemWidth(5 * ImGui::GetFontSize());
+      ImGui::DragFloat(
+          "target", &dynamicResolution.targetFPS, 1.f, 1.f, 240.f, "%.0f fps");
+      ImGui::SetNextItemWidth(10 * ImGui::GetFontSize());
+      ImGui::DragFloatRange2("scale range",
+          &dynamicResolution.minScale,
+          &dynamicResolution.maxScale,
+          dynamicResolution.quantum,
+          dynamicResolution.quantum,
+          1.f);
+    }
   }
 
   ImGui::Separator();
@@ -2857,6 +3080,7 @@ void MainWindow::buildWindowRenderingStats()
   ImGui::SameLine();
   ImGui::Text("x%1.2f", scale);
   ImGui::Text("framerate: %-4.1f fps", latestFPS);
+  ImGui::Text("display latency: %-4.2f ms", latestDisplayLatency);
   ImGui::Text("ui framerate: %-4.1f fps", ImGui::GetIO().Framerate);
 
   if (varianceThreshold == 0) {
@@ -12,6 +12,7 @@
 #include "sg/Frame.h"
 #include "sg/renderer/MaterialRegistry.h"
 // std
+#include <cstddef>
 #include <functional>
 
 #include <map>
@@ -38,6 +39,22 @@ using rkcommon::make_unique;
 #ifndef GL_RGB32F
 #define GL_RGB32F 0x8815
 #endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef APIENTRY
+#ifdef _WIN32
+#define APIENTRY __stdcall
+#else
+#define APIENTRY
+#endif
+#endif
 
 enum class OSPRayRendererType
 {
@@ -111,6 +128,9 @@ class MainWindow : public StudioContext
   void display();
   void startNewOSPRayFrame();
   void waitOnOSPRayFrame();
+  void initFramebufferUpload();
+  void *beginFramebufferUpload(size_t numBytes);
+  void endFramebufferUpload(GLenum internalFormat, GLenum format, GLenum type);
   void buildUI();
   void addLight();
   void removeLight();
@@ -182,8 +202,29 @@ class MainWindow : public StudioContext
   // GLFW window instance
   GLFWwindow *glfwWindow = nullptr;
 
-  // OpenGL framebuffer texture
+  // OpenGL framebuffer texture, its storage is only reallocated when the
+  // size or format of the frame changes
   GLuint framebufferTexture = 0;
+  vec2i framebufferTextureSize{0};
+  GLenum framebufferTextureFormat = 0;
+
+  // Pixel buffer objects staging frames for upload, used in turns.  The
+  // transfer to the texture then runs while OSPRay renders the next frame.
+  // Loaded at runtime (OpenGL 2.1), as Windows only exports OpenGL 1.1.
+  struct
+  {
+    void(APIENTRY *genBuffers)(GLsizei, GLuint *);
+    void(APIENTRY *deleteBuffers)(GLsizei, const GLuint *);
+    void(APIENTRY *bindBuffer)(GLenum, GLuint);
+    void(APIENTRY *bufferData)(GLenum, std::ptrdiff_t, const void *, GLenum);
+    void *(APIENTRY *mapBuffer)(GLenum, GLenum);
+    GLboolean(APIENTRY *unmapBuffer)(GLenum);
+  } glPBO{};
+  GLuint pixelBuffers[2] = {0, 0};
+  int pixelBufferIndex = 0;
+  bool pixelBufferMapped = false;
+  // Staging memory without pixel buffer objects
+  std::vector<uint8_t> stagingFrame;
 
   // optional registered display callback, called before every display()
   std::function<void(MainWindow *)> displayCallback;
@@ -201,6 +242,8 @@ class MainWindow : public StudioContext
 
   // FPS measurement of last frame
   float latestFPS{0.f};
+  // Time from the last frame being ready to starting the next one, in ms
+  float latestDisplayLatency{0.f};
 
   // auto rotation speed, 1=0.1% window width mouse movement, 100=10%
   int autorotateSpeed{1};
@@ -222,6 +265,7 @@ class MainWindow : public StudioContext
   bool optShowAlbedo{false};
   bool optShowDepth{false};
   bool optShowDepthInvert{false};
+  bool optShowNormal{false};
   bool optAutorotate{false};
   bool optAnimate{false};
 };
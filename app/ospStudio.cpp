@@ -8,6 +8,9 @@
 #include "Batch.h"
 #include "TimeSeriesWindow.h"
 #include "sg/Mpi.h"
+#include "sg/exporter/ExportQueue.h"
+#include "sg/importer/SceneCache.h"
+#include "sg/visitors/Commit.h"
 
 // CLI
 #include <CLI11.hpp>
@@ -214,11 +217,31 @@ void StudioContext::addToCommandLine (std::shared_ptr<CLI::App> app) {
     frameAccumLimit,
     "Set accumulation limit for the frame"
   )->check(CLI::PositiveNumber);
+  app->add_flag(
+    "--pipelined",
+    optPipelined,
+    "Render the next frame while the last one is displayed or saved"
+  );
+  app->add_option(
+    "--exportThreads",
+    sg::exportSettings.numThreads,
+    "Save images on this many background threads (default 0, saves in place)"
+  );
+  app->add_option(
+    "--cacheDir",
+    sg::sceneCacheSettings.directory,
+    "Cache imported models in this directory, reused while unchanged"
+  );
   app->add_flag(
     "--async-tasking{true},--no-async-tasking{false}",
     optDoAsyncTasking,
     "Disable asynchronous tasking (and asynchronous dataset loading)"
   );
+  app->add_flag(
+    "--parallel-commit{true},--no-parallel-commit{false}",
+    sg::commitSettings.parallel,
+    "Commit independent scene subtrees in parallel (default on)"
+  );
 }
 //}}}
 //{{{
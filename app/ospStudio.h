@@ -178,6 +178,7 @@ class StudioContext : public std::enable_shared_from_this<StudioContext>
   bool optDoAsyncTasking{false};
   float maxContribution{math::inf};
   int frameAccumLimit{0};
+  bool optPipelined{false};
   std::string optImageName{"studio"}; // (each mode sets this default)
   std::string optImageFormat{"png"};
   bool optSaveAlbedo{false};
@@ -138,8 +138,10 @@ void SearchWidget::addSearchResultsUI(NR root)
         ImGui::SetItemDefaultFocus();
     }
   } else {
-    for (int i = 0; i < root.children().size(); i++) {
-      auto &node = root.children().at_index(i);
+    // Iterated, as at_index() walks the children once any was removed
+    int i = -1;
+    for (auto &node : root.children()) {
+      i++;
       if (isOneOf(node.second->type(), displayTypes)) {
         const bool isSelected = (selectedIndex == i);
         if (ImGui::Selectable(node.first.c_str(), isSelected)) {
@@ -68,6 +68,14 @@ namespace ospray {
     OSPDataType format;
     bool isShared;
 
+    // Application memory of shared data (nullptr for copied data), which
+    // must outlive the node, and the size of its items
+    const void *sharedMemory{nullptr};
+    size_t itemBytes{0};
+
+    // Whether shared items are stored one after the other, without gaps
+    bool isDense() const;
+
    private:
     template <typename T>
     void validate_element_type();
@@ -132,6 +140,9 @@ namespace ospray {
 
     auto format = OSPTypeFor<T>::value;
     this->format = format;
+    itemBytes = sizeof(T);
+    if (isShared)
+      sharedMemory = init;
 
     auto tmp = ospNewSharedData(init,
                                 format,
@@ -191,6 +202,17 @@ namespace ospray {
     validate_element_type<T>();
   }
 
+  inline bool Data::isDense() const
+  {
+    if (!sharedMemory)
+      return false;
+    const auto x = numItems.x * itemBytes;
+    return (byteStride.x == 0 || byteStride.x == itemBytes)
+        && (numItems.y == 1 || byteStride.y == 0 || byteStride.y == x)
+        && (numItems.z == 1 || byteStride.z == 0
+            || byteStride.z == x * numItems.y);
+  }
+
   template <typename T>
   inline void Data::validate_element_type()
   {
@@ -46,11 +46,24 @@ void Frame::startNewFrame()
   if (navMode != child("navMode").valueAs<bool>())
     child("navMode") = navMode && (!navMode || isModified());
 
+  updateNavScale();
+  fb.setPipelined(pipelined);
+
   // If working on a frame, cancel it, something has changed
-  if (isModified()) {
+  if (isModified() && !keepsAccumulation(fb)) {
+    // Accumulation restarts, a completed frame stays available in the spare
+    // framebuffer while the next one renders
+    const bool keepCompleted = pipelined && frameIsReady() && !canceled;
     cancelFrame();
     waitOnFrame();
+    if (keepCompleted)
+      fb.swapBuffers();
     resetAccumulation();
+  } else if (isModified()) {
+    // The accumulated image stays valid, but needs another frame to show the
+    // new image operations
+    waitOnFrame();
+    presentImageOps = true;
   }
 
   refreshFrameOperations();
@@ -59,11 +72,13 @@ void Frame::startNewFrame()
   if (isModified())
     commit();
 
-  if (!(pauseRendering || accumLimitReached() || varThresholdReached())) {
+  const bool accumulated = accumLimitReached() || varThresholdReached();
+  if (!pauseRendering && (!accumulated || presentImageOps)) {
     auto future = fb.handle().renderFrame(
         renderer.handle(), camera.handle(), world.handle());
     setHandle(future, false); // setHandle but don't update modified time
     canceled = false;
+    presentImageOps = false;
 
     if (immediatelyWait)
       waitOnFrame();
@@ -132,9 +147,7 @@ bool Frame::varThresholdReached()
 
 const void *Frame::mapFrame(OSPFrameBufferChannel channel)
 {
-  waitOnFrame();
-  auto &fb = childAs<FrameBuffer>("framebuffer");
-  return fb.map(channel);
+  return completedFrameBuffer().map(channel);
 }
 
 void Frame::unmapFrame(void *mem)
@@ -144,9 +157,88 @@ void Frame::unmapFrame(void *mem)
 }
 
 void Frame::saveFrame(std::string filename, int flags)
+{
+  completedFrameBuffer().saveFrame(filename, flags);
+}
+
+std::vector<ScenePick> Frame::pick(const std::vector<vec2f> &screenPositions)
+{
+  auto &fb = childAs<FrameBuffer>("framebuffer");
+  auto &camera = childAs<Camera>("camera");
+  auto &renderer = childAs<Renderer>("renderer");
+  auto &world = childAs<World>("world");
+
+  // OSPRay picks one position at a time, but the handles are only fetched
+  // once and resolved without touching the scene graph
+  const auto &fbHandle = fb.handle();
+  const auto &rendererHandle = renderer.handle();
+  const auto &cameraHandle = camera.handle();
+  const auto &worldHandle = world.handle();
+
+  std::vector<ScenePick> picks;
+  picks.reserve(screenPositions.size());
+  for (auto &pos : screenPositions) {
+    auto result = fbHandle.pick(
+        rendererHandle, cameraHandle, worldHandle, pos.x, pos.y);
+    picks.push_back(world.resolvePick(result));
+  }
+
+  return picks;
+}
+
+// Whether the modifications since the last commit leave the accumulated
+// image valid, ie. only the framebuffer's image operations changed
+bool Frame::keepsAccumulation(FrameBuffer &fb)
+{
+  if (lastModified() > lastCommitted())
+    return false;
+
+  for (auto &c : children()) {
+    if (!c.second->isModified())
+      continue;
+    if (c.second.get() != &fb
+        || fb.pendingChange() == FrameBuffer::Change::BUFFER)
+      return false;
+  }
+
+  return true;
+}
+
+void Frame::updateNavScale()
+{
+  const auto now = std::chrono::steady_clock::now();
+  const bool timing = dynamicResolution.enabled && navMode;
+
+  // Only intervals between navigation frames count, the first one after a
+  // pause would include the idle time
+  if (timing && timingNavFrames) {
+    auto &scaleNav = child("scaleNav");
+    const float seconds =
+        std::chrono::duration<float>(now - lastFrameStart).count();
+    const float scale = scaleNav.valueAs<float>();
+    const float newScale = dynamicResolution.update(seconds, scale);
+    if (newScale != scale)
+      scaleNav = newScale;
+  } else if (!timing) {
+    dynamicResolution.restart();
+  }
+
+  timingNavFrames = timing;
+  lastFrameStart = now;
+}
+
+FrameBuffer &Frame::completedFrameBuffer()
 {
   auto &fb = childAs<FrameBuffer>("framebuffer");
-  fb.saveFrame(filename, flags);
+
+  // Without a completed frame in the spare framebuffer, or once the frame in
+  // flight is done, the framebuffer rendered into is the one to read
+  if (!fb.completedInSpare() || frameIsReady()) {
+    waitOnFrame();
+    fb.presentRendered();
+  }
+
+  return fb;
 }
 
 void Frame::refreshFrameOperations()
@@ -168,14 +260,13 @@ void Frame::refreshFrameOperations()
   fb.updateImageOperations();
 
   uint8_t newFrameOpsState = denoiserEnabled << 1 | toneMapperEnabled;
-  static uint8_t lastFrameOpsState{0};
 
-  // If there's a change and accumLimit is already reach, force another frame so
-  // operations will occur
-  if ((newFrameOpsState != lastFrameOpsState) && accumLimitReached())
-    currentAccum--;
+  // If there's a change, render another frame even if accumulation is
+  // complete, so operations will occur
+  if (newFrameOpsState != frameOpsState)
+    presentImageOps = true;
 
-  lastFrameOpsState = newFrameOpsState;
+  frameOpsState = newFrameOpsState;
 }
 
 void Frame::preCommit()
@@ -200,6 +291,55 @@ void Frame::preCommit()
 
 void Frame::postCommit() {}
 
+// DynamicResolution definitions /////////////////////////////////////////////
+
+float DynamicResolution::update(float seconds, float scale)
+{
+  // The first frame at a new scale also pays for the new framebuffer
+  if (framesToSkip > 0) {
+    framesToSkip--;
+    return scale;
+  }
+
+  averageSeconds = averageSeconds > 0.f
+      ? 0.7f * averageSeconds + 0.3f * seconds
+      : seconds;
+
+  const float target = 1.f / std::max(targetFPS, 1.f);
+  if (averageSeconds > target * (1.f + tolerance)) {
+    framesSlow++;
+    framesFast = 0;
+  } else if (averageSeconds < target * (1.f - tolerance)) {
+    framesFast++;
+    framesSlow = 0;
+  } else {
+    framesSlow = framesFast = 0;
+  }
+
+  if (framesSlow < patience && framesFast < patience)
+    return scale;
+
+  // Frame time is about proportional to the number of pixels
+  float newScale = scale * std::sqrt(target / averageSeconds);
+  newScale = std::round(newScale / quantum) * quantum;
+  newScale = std::max(minScale, std::min(newScale, maxScale));
+
+  framesSlow = framesFast = 0;
+  if (std::abs(newScale - scale) < 0.5f * quantum)
+    return scale;
+
+  averageSeconds = 0.f;
+  framesToSkip = 1;
+  return newScale;
+}
+
+void DynamicResolution::restart()
+{
+  averageSeconds = 0.f;
+  framesSlow = framesFast = 0;
+  framesToSkip = 0;
+}
+
 OSP_REGISTER_SG_NODE_NAME(Frame, frame);
 
 } // namespace sg
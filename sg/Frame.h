@@ -11,10 +11,38 @@
 #include "renderer/Renderer.h"
 #include "scene/World.h"
 #include "scene/lights/LightsManager.h"
+// stl
+#include <chrono>
 
 namespace ospray {
   namespace sg {
 
+  // Picks the navigation scale from measured frame times, aiming at a target
+  // frame rate.  The scale only changes once the (smoothed) frame time stays
+  // outside a band around the target for a few frames, and then in steps of
+  // whole quanta, so the framebuffer isn't recreated every frame.
+  struct OSPSG_INTERFACE DynamicResolution
+  {
+    bool enabled{false};
+    float targetFPS{30.f};
+    float minScale{0.125f};
+    float maxScale{1.f};
+    float tolerance{0.25f}; // band around the target frame time, relative
+    int patience{3}; // frames outside the band before rescaling
+    float quantum{1.f / 16}; // scales are multiples of this
+
+    // Scale to use after a frame of 'seconds' rendered at 'scale'
+    float update(float seconds, float scale);
+    // Forgets past frame times, ie. when interaction stops
+    void restart();
+
+   private:
+    float averageSeconds{0.f};
+    int framesSlow{0};
+    int framesFast{0};
+    int framesToSkip{0};
+  };
+
   struct OSPSG_INTERFACE Frame : public OSPNode<cpp::Future, NodeType::FRAME>
   {
     Frame();
@@ -56,8 +84,19 @@ namespace ospray {
     void unmapFrame(void *mem);
     void saveFrame(std::string filename, int flags);
 
+    // Picks the scene at each of 'screenPositions' (in [0-1], origin at the
+    // bottom left), resolved to scene graph nodes
+    std::vector<ScenePick> pick(const std::vector<vec2f> &screenPositions);
+
+    // Adjusts "scaleNav" during navigation, see DynamicResolution
+    DynamicResolution dynamicResolution;
+
     bool immediatelyWait{false};
     bool pauseRendering{false};
+    // Renders into a second framebuffer whenever accumulation restarts, so the
+    // next frame can start while the last completed one is still mapped or
+    // saved.  Mapped memory must be unmapped before the next startNewFrame().
+    bool pipelined{false};
     int accumLimit{0};
     int currentAccum{0};
     bool canceled{false};
@@ -68,7 +107,16 @@ namespace ospray {
 
    private:
     bool navMode{false};
+    bool timingNavFrames{false};
+    // Image operations changed, the next frame renders even once
+    // accumulation is complete
+    bool presentImageOps{false};
+    uint8_t frameOpsState{0};
+    std::chrono::steady_clock::time_point lastFrameStart;
+    void updateNavScale();
+    bool keepsAccumulation(FrameBuffer &fb);
     void refreshFrameOperations();
+    FrameBuffer &completedFrameBuffer();
     void preCommit() override;
     void postCommit() override;
   };
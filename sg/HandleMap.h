@@ -0,0 +1,181 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// stl
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ospray {
+  namespace sg {
+
+  // Hash map from OSPRay handles (or any other pointers) to values, in a flat
+  // open addressing table with linear probing.  Keys are kept apart from the
+  // values, so lookups only scan a contiguous array of pointers, and values
+  // are only touched on hits.  Erasing shifts the following entries back
+  // instead of leaving tombstones, the table never needs rebuilding because
+  // of churn.
+  //
+  // NOTE: the null handle can't be a key, it marks empty slots
+  template <typename HANDLE, typename VALUE>
+  struct HandleMap
+  {
+    HandleMap()  = default;
+    ~HandleMap() = default;
+
+    // Inserts a default value if 'handle' isn't a key yet
+    VALUE &operator[](HANDLE handle);
+
+    // nullptr if 'handle' isn't a key
+    VALUE *find(HANDLE handle);
+    const VALUE *find(HANDLE handle) const;
+
+    bool contains(HANDLE handle) const;
+    bool erase(HANDLE handle);
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+
+   private:
+    size_t home(HANDLE handle) const;
+    size_t lookup(HANDLE handle) const; // slot of 'handle', or of a free one
+    void grow();
+
+    std::vector<HANDLE> keys; // power of two size, at most half full
+    std::vector<VALUE> values;
+    size_t numKeys{0};
+  };
+
+  // Inlined definitions //////////////////////////////////////////////////////
+
+  template <typename HANDLE, typename VALUE>
+  inline VALUE &HandleMap<HANDLE, VALUE>::operator[](HANDLE handle)
+  {
+    if (2 * (numKeys + 1) > keys.size())
+      grow();
+
+    const size_t slot = lookup(handle);
+    if (!keys[slot]) {
+      keys[slot] = handle;
+      numKeys++;
+    }
+    return values[slot];
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline VALUE *HandleMap<HANDLE, VALUE>::find(HANDLE handle)
+  {
+    if (keys.empty() || !handle)
+      return nullptr;
+    const size_t slot = lookup(handle);
+    return keys[slot] ? &values[slot] : nullptr;
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline const VALUE *HandleMap<HANDLE, VALUE>::find(HANDLE handle) const
+  {
+    if (keys.empty() || !handle)
+      return nullptr;
+    const size_t slot = lookup(handle);
+    return keys[slot] ? &values[slot] : nullptr;
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline bool HandleMap<HANDLE, VALUE>::contains(HANDLE handle) const
+  {
+    return find(handle) != nullptr;
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline bool HandleMap<HANDLE, VALUE>::erase(HANDLE handle)
+  {
+    if (keys.empty() || !handle)
+      return false;
+
+    size_t hole = lookup(handle);
+    if (!keys[hole])
+      return false;
+
+    // Move back the entries of the probe sequence which the hole would cut
+    // off from their home slot
+    const size_t mask = keys.size() - 1;
+    for (size_t slot = (hole + 1) & mask; keys[slot]; slot = (slot + 1) & mask) {
+      const size_t h = home(keys[slot]);
+      const bool reachable = hole <= slot ? (hole < h && h <= slot)
+                                          : (hole < h || h <= slot);
+      if (reachable)
+        continue;
+
+      keys[hole]   = keys[slot];
+      values[hole] = std::move(values[slot]);
+      hole         = slot;
+    }
+
+    keys[hole]   = HANDLE();
+    values[hole] = VALUE();
+    numKeys--;
+    return true;
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline void HandleMap<HANDLE, VALUE>::clear()
+  {
+    keys.clear();
+    values.clear();
+    numKeys = 0;
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline size_t HandleMap<HANDLE, VALUE>::size() const
+  {
+    return numKeys;
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline bool HandleMap<HANDLE, VALUE>::empty() const
+  {
+    return numKeys == 0;
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline size_t HandleMap<HANDLE, VALUE>::home(HANDLE handle) const
+  {
+    // Fibonacci hashing, handles are aligned so their low bits are constant
+    const uint64_t h = uint64_t(uintptr_t(handle)) * 0x9E3779B97F4A7C15ull;
+    return size_t(h >> 32) & (keys.size() - 1);
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline size_t HandleMap<HANDLE, VALUE>::lookup(HANDLE handle) const
+  {
+    const size_t mask = keys.size() - 1;
+    size_t slot       = home(handle);
+    while (keys[slot] && keys[slot] != handle)
+      slot = (slot + 1) & mask;
+    return slot;
+  }
+
+  template <typename HANDLE, typename VALUE>
+  inline void HandleMap<HANDLE, VALUE>::grow()
+  {
+    std::vector<HANDLE> oldKeys(std::max<size_t>(16, 2 * keys.size()));
+    std::vector<VALUE> oldValues(oldKeys.size());
+    keys.swap(oldKeys);
+    values.swap(oldValues);
+
+    for (size_t i = 0; i < oldKeys.size(); i++) {
+      if (!oldKeys[i])
+        continue;
+      const size_t slot = lookup(oldKeys[i]);
+      keys[slot]        = oldKeys[i];
+      values[slot]      = std::move(oldValues[i]);
+    }
+  }
+
+  }  // namespace sg
+} // namespace ospray
@@ -0,0 +1,602 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ospray {
+  namespace sg {
+
+  // A drop-in replacement for rkcommon::containers::FlatMap<> that keeps the
+  // insertion-ordered std::vector<> storage (so iteration and at_index() work
+  // exactly as before), but adds a hashed key->index side table for O(1)
+  // key lookups.  The side table is only built once the map grows past
+  // 'indexThreshold' entries, so the many small maps (ie. parameter nodes
+  // with a handful of children) don't pay for it.
+  //
+  // Erasing from an indexed map leaves a tombstone instead of shifting (and
+  // re-indexing) every following entry.  Iterators skip tombstones, which
+  // are compacted away once they outnumber the live entries, so erasing in
+  // any order is amortized O(1).  at_index() walks the storage while there
+  // are tombstones.
+  //
+  // NOTE: keys must not be modified through iterators, the index would go
+  //       stale.
+  template <typename KEY, typename VALUE>
+  struct HashedFlatMap
+  {
+    using item_t    = std::pair<KEY, VALUE>;
+    using storage_t = std::vector<item_t>;
+    using index_t   = std::unordered_map<KEY, size_t>;
+
+    // Bidirectional iterator over the live entries
+    template <typename ITEM_T>
+    struct Iterator
+    {
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type        = typename std::remove_const<ITEM_T>::type;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = ITEM_T *;
+      using reference         = ITEM_T &;
+
+      Iterator() = default;
+      Iterator(ITEM_T *items, const uint8_t *erased, size_t pos, size_t size);
+
+      // iterator_t converts to citerator_t
+      template <typename T,
+          typename = typename std::enable_if<
+              std::is_same<const T, ITEM_T>::value>::type>
+      Iterator(const Iterator<T> &other);
+
+      reference operator*() const;
+      pointer operator->() const;
+
+      Iterator &operator++();
+      Iterator operator++(int);
+      Iterator &operator--();
+      Iterator operator--(int);
+
+      template <typename T>
+      bool operator==(const Iterator<T> &other) const;
+      template <typename T>
+      bool operator!=(const Iterator<T> &other) const;
+
+     private:
+      template <typename T>
+      friend struct Iterator;
+
+      void skipErased();
+
+      ITEM_T *items{nullptr};
+      const uint8_t *erased{nullptr}; // nullptr without tombstones
+      size_t pos{0};
+      size_t size{0};
+    };
+
+    using iterator_t   = Iterator<item_t>;
+    using citerator_t  = Iterator<const item_t>;
+    using riterator_t  = std::reverse_iterator<iterator_t>;
+    using criterator_t = std::reverse_iterator<citerator_t>;
+
+    static constexpr size_t indexThreshold = 8;
+
+    HashedFlatMap()  = default;
+    ~HashedFlatMap() = default;
+
+    // Key-based lookups //
+
+    VALUE &at(const KEY &key);
+    const VALUE &at(const KEY &key) const;
+
+    VALUE &operator[](const KEY &key);
+
+    // Inserts 'value' unless 'key' is already in the map.  Returns the
+    // entry of 'key' and whether it was inserted.
+    std::pair<iterator_t, bool> emplace(const KEY &key, VALUE value);
+
+    iterator_t find(const KEY &key);
+    citerator_t find(const KEY &key) const;
+
+    // Index-based lookups //
+
+    item_t &at_index(size_t index);
+    const item_t &at_index(size_t index) const;
+
+    // Property queries //
+
+    size_t size() const;
+    bool empty() const;
+
+    bool contains(const KEY &key) const;
+
+    // Storage mutation //
+
+    void erase(const KEY &key);
+
+    void clear();
+    void reserve(size_t size);
+
+    // Iterators //
+
+    iterator_t begin();
+    citerator_t begin() const;
+    citerator_t cbegin() const;
+
+    iterator_t end();
+    citerator_t end() const;
+    citerator_t cend() const;
+
+    riterator_t rbegin();
+    criterator_t rbegin() const;
+    criterator_t crbegin() const;
+
+    riterator_t rend();
+    criterator_t rend() const;
+    criterator_t crend() const;
+
+   private:
+    // Helpers //
+
+    size_t lookup(const KEY &key) const; // returns values.size() if not found
+    size_t append(const KEY &key, VALUE value);
+    void buildIndex();
+    void compact();
+    const uint8_t *erasedFlags() const;
+    iterator_t iteratorAt(size_t pos);
+    citerator_t iteratorAt(size_t pos) const;
+
+    // Data //
+
+    storage_t values;
+    index_t index;
+    bool indexed{false};
+
+    // Tombstones of erased entries, only sized while there are any
+    std::vector<uint8_t> erased;
+    size_t numErased{0};
+  };
+
+  // Iterator definitions /////////////////////////////////////////////////////
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  inline HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::Iterator(
+      ITEM_T *items, const uint8_t *erased, size_t pos, size_t size)
+      : items(items), erased(erased), pos(pos), size(size)
+  {
+    skipErased();
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  template <typename T, typename>
+  inline HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::Iterator(
+      const Iterator<T> &other)
+      : items(other.items),
+        erased(other.erased),
+        pos(other.pos),
+        size(other.size)
+  {}
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  inline typename HashedFlatMap<KEY, VALUE>::template Iterator<
+      ITEM_T>::reference
+  HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::operator*() const
+  {
+    return items[pos];
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  inline typename HashedFlatMap<KEY, VALUE>::template Iterator<ITEM_T>::pointer
+  HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::operator->() const
+  {
+    return items + pos;
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  inline typename HashedFlatMap<KEY, VALUE>::template Iterator<ITEM_T> &
+  HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::operator++()
+  {
+    pos++;
+    skipErased();
+    return *this;
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  inline typename HashedFlatMap<KEY, VALUE>::template Iterator<ITEM_T>
+  HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::operator++(int)
+  {
+    auto previous = *this;
+    ++*this;
+    return previous;
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  inline typename HashedFlatMap<KEY, VALUE>::template Iterator<ITEM_T> &
+  HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::operator--()
+  {
+    do
+      pos--;
+    while (erased && erased[pos]);
+    return *this;
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  inline typename HashedFlatMap<KEY, VALUE>::template Iterator<ITEM_T>
+  HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::operator--(int)
+  {
+    auto previous = *this;
+    --*this;
+    return previous;
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  template <typename T>
+  inline bool HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::operator==(
+      const Iterator<T> &other) const
+  {
+    return pos == other.pos && items == other.items;
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  template <typename T>
+  inline bool HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::operator!=(
+      const Iterator<T> &other) const
+  {
+    return !(*this == other);
+  }
+
+  template <typename KEY, typename VALUE>
+  template <typename ITEM_T>
+  inline void HashedFlatMap<KEY, VALUE>::Iterator<ITEM_T>::skipErased()
+  {
+    if (erased)
+      while (pos < size && erased[pos])
+        pos++;
+  }
+
+  // Inlined definitions //////////////////////////////////////////////////////
+
+  template <typename KEY, typename VALUE>
+  inline VALUE &HashedFlatMap<KEY, VALUE>::at(const KEY &key)
+  {
+    auto i = lookup(key);
+    if (i == values.size())
+      throw std::out_of_range("key wasn't found in HashedFlatMap<>");
+    return values[i].second;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline const VALUE &HashedFlatMap<KEY, VALUE>::at(const KEY &key) const
+  {
+    auto i = lookup(key);
+    if (i == values.size())
+      throw std::out_of_range("key wasn't found in HashedFlatMap<>");
+    return values[i].second;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline VALUE &HashedFlatMap<KEY, VALUE>::operator[](const KEY &key)
+  {
+    auto i = lookup(key);
+    if (i == values.size())
+      i = append(key, VALUE());
+    return values[i].second;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline std::pair<typename HashedFlatMap<KEY, VALUE>::iterator_t, bool>
+  HashedFlatMap<KEY, VALUE>::emplace(const KEY &key, VALUE value)
+  {
+    auto i = lookup(key);
+    if (i != values.size())
+      return {iteratorAt(i), false};
+    return {iteratorAt(append(key, std::move(value))), true};
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::iterator_t
+  HashedFlatMap<KEY, VALUE>::find(const KEY &key)
+  {
+    return iteratorAt(lookup(key));
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::citerator_t
+  HashedFlatMap<KEY, VALUE>::find(const KEY &key) const
+  {
+    return iteratorAt(lookup(key));
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::item_t &
+  HashedFlatMap<KEY, VALUE>::at_index(size_t i)
+  {
+    const auto &self = *this;
+    return const_cast<item_t &>(self.at_index(i));
+  }
+
+  template <typename KEY, typename VALUE>
+  inline const typename HashedFlatMap<KEY, VALUE>::item_t &
+  HashedFlatMap<KEY, VALUE>::at_index(size_t i) const
+  {
+    if (!numErased)
+      return values.at(i);
+
+    for (size_t j = 0; j < values.size(); j++)
+      if (!erased[j] && i-- == 0)
+        return values[j];
+
+    throw std::out_of_range("index out of range in HashedFlatMap<>");
+  }
+
+  template <typename KEY, typename VALUE>
+  inline size_t HashedFlatMap<KEY, VALUE>::size() const
+  {
+    return values.size() - numErased;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline bool HashedFlatMap<KEY, VALUE>::empty() const
+  {
+    return size() == 0;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline bool HashedFlatMap<KEY, VALUE>::contains(const KEY &key) const
+  {
+    return lookup(key) != values.size();
+  }
+
+  template <typename KEY, typename VALUE>
+  inline void HashedFlatMap<KEY, VALUE>::erase(const KEY &key)
+  {
+    auto i = lookup(key);
+    if (i == values.size())
+      return;
+
+    // Small maps just shift the following entries down
+    if (!indexed) {
+      values.erase(values.begin() + i);
+      return;
+    }
+
+    // NOTE: 'key' may reference the stored key itself, so drop it from the
+    //       index before the entry changes
+    index.erase(key);
+
+    if (i + 1 == values.size()) {
+      // Erasing the last entry, ie. removeAllChildren(), needs no tombstone,
+      // and tombstones before it can go as well
+      values.pop_back();
+      if (numErased) {
+        erased.pop_back();
+        while (!values.empty() && erased.back()) {
+          values.pop_back();
+          erased.pop_back();
+          numErased--;
+        }
+        if (!numErased)
+          erased.clear();
+      }
+      return;
+    }
+
+    if (!numErased)
+      erased.assign(values.size(), 0);
+    erased[i] = 1;
+    numErased++;
+    // Release the entry right away, only its slot is kept
+    values[i] = item_t();
+
+    if (numErased > values.size() - numErased)
+      compact();
+  }
+
+  template <typename KEY, typename VALUE>
+  inline void HashedFlatMap<KEY, VALUE>::clear()
+  {
+    values.clear();
+    index.clear();
+    indexed = false;
+    erased.clear();
+    numErased = 0;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline void HashedFlatMap<KEY, VALUE>::reserve(size_t size)
+  {
+    values.reserve(size);
+    if (size > indexThreshold) {
+      buildIndex();
+      index.reserve(size);
+    }
+  }
+
+  // Iterators //
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::iterator_t
+  HashedFlatMap<KEY, VALUE>::begin()
+  {
+    return iteratorAt(0);
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::citerator_t
+  HashedFlatMap<KEY, VALUE>::begin() const
+  {
+    return cbegin();
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::citerator_t
+  HashedFlatMap<KEY, VALUE>::cbegin() const
+  {
+    return iteratorAt(0);
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::iterator_t
+  HashedFlatMap<KEY, VALUE>::end()
+  {
+    return iteratorAt(values.size());
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::citerator_t
+  HashedFlatMap<KEY, VALUE>::end() const
+  {
+    return cend();
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::citerator_t
+  HashedFlatMap<KEY, VALUE>::cend() const
+  {
+    return iteratorAt(values.size());
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::riterator_t
+  HashedFlatMap<KEY, VALUE>::rbegin()
+  {
+    return riterator_t(end());
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::criterator_t
+  HashedFlatMap<KEY, VALUE>::rbegin() const
+  {
+    return crbegin();
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::criterator_t
+  HashedFlatMap<KEY, VALUE>::crbegin() const
+  {
+    return criterator_t(cend());
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::riterator_t
+  HashedFlatMap<KEY, VALUE>::rend()
+  {
+    return riterator_t(begin());
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::criterator_t
+  HashedFlatMap<KEY, VALUE>::rend() const
+  {
+    return crend();
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::criterator_t
+  HashedFlatMap<KEY, VALUE>::crend() const
+  {
+    return criterator_t(cbegin());
+  }
+
+  // Helper functions //
+
+  template <typename KEY, typename VALUE>
+  inline size_t HashedFlatMap<KEY, VALUE>::lookup(const KEY &key) const
+  {
+    if (indexed) {
+      auto itr = index.find(key);
+      return itr == index.end() ? values.size() : itr->second;
+    }
+
+    for (size_t i = 0; i < values.size(); i++)
+      if (values[i].first == key)
+        return i;
+
+    return values.size();
+  }
+
+  template <typename KEY, typename VALUE>
+  inline size_t HashedFlatMap<KEY, VALUE>::append(const KEY &key, VALUE value)
+  {
+    const size_t i = values.size();
+    values.emplace_back(key, std::move(value));
+    if (numErased)
+      erased.push_back(0);
+
+    if (indexed)
+      index.emplace(key, i);
+    else if (values.size() > indexThreshold)
+      buildIndex();
+
+    return i;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline void HashedFlatMap<KEY, VALUE>::compact()
+  {
+    size_t live = 0;
+    for (size_t i = 0; i < values.size(); i++) {
+      if (erased[i])
+        continue;
+      if (i != live) {
+        values[live] = std::move(values[i]);
+        index.find(values[live].first)->second = live;
+      }
+      live++;
+    }
+
+    values.erase(values.begin() + live, values.end());
+    erased.clear();
+    numErased = 0;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline const uint8_t *HashedFlatMap<KEY, VALUE>::erasedFlags() const
+  {
+    return numErased ? erased.data() : nullptr;
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::iterator_t
+  HashedFlatMap<KEY, VALUE>::iteratorAt(size_t pos)
+  {
+    return iterator_t(values.data(), erasedFlags(), pos, values.size());
+  }
+
+  template <typename KEY, typename VALUE>
+  inline typename HashedFlatMap<KEY, VALUE>::citerator_t
+  HashedFlatMap<KEY, VALUE>::iteratorAt(size_t pos) const
+  {
+    return citerator_t(values.data(), erasedFlags(), pos, values.size());
+  }
+
+  template <typename KEY, typename VALUE>
+  inline void HashedFlatMap<KEY, VALUE>::buildIndex()
+  {
+    if (indexed)
+      return;
+
+    index.reserve(values.size());
+    for (size_t i = 0; i < values.size(); i++)
+      index.emplace(values[i].first, i);
+    indexed = true;
+  }
+
+  }  // namespace sg
+} // namespace ospray
@@ -25,13 +25,14 @@ inline void from_json(const JSON &j, CameraState &cs);
 
 // rkcommon type declarations /////////////////////////////////////////
 
+namespace ospray {
+namespace sg {
+inline void to_json(JSON &j, const NodeMap &nm);
+inline void from_json(const JSON &j, NodeMap &nm);
+} // namespace sg
+} // namespace ospray
+
 namespace rkcommon {
-namespace containers {
-void to_json(
-    JSON &j, const FlatMap<std::string, ospray::sg::NodePtr> &fm);
-void from_json(
-    const JSON &j, FlatMap<std::string, ospray::sg::NodePtr> &fm);
-} // namespace containers
 namespace math {
 inline void to_json(JSON &j, const LinearSpace2f &as);
 inline void from_json(const JSON &j, LinearSpace2f &as);
@@ -101,6 +102,17 @@ inline void to_json(JSON &j, const Node &n)
 
 inline void from_json(const JSON &, Node &) {}
 
+inline void to_json(JSON &j, const NodeMap &nm)
+{
+  for (const auto &e : nm) {
+    JSON jnew = *(e.second);
+    if (!jnew.is_null())
+      j.push_back(jnew);
+  }
+}
+
+inline void from_json(const JSON &, NodeMap &) {}
+
 inline OSPSG_INTERFACE NodePtr createNodeFromJSON(const JSON &j) {
   NodePtr n = nullptr;
 
@@ -201,24 +213,6 @@ inline OSPSG_INTERFACE NodePtr createNodeFromJSON(const JSON &j) {
 ///////////////////////////////////////////////////////////////////////
 
 namespace rkcommon {
-namespace containers {
-
-inline void to_json(
-    JSON &j, const FlatMap<std::string, ospray::sg::NodePtr> &fm)
-{
-  for (const auto e : fm) {
-    JSON jnew = *(e.second);
-    if (!jnew.is_null())
-      j.push_back(jnew);
-  }
-}
-
-inline void from_json(
-    const JSON &, FlatMap<std::string, ospray::sg::NodePtr> &)
-{}
-
-} // namespace containers
-
 namespace math {
 
 inline void to_json(JSON &j, const vec2i &v)
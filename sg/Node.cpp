@@ -8,6 +8,8 @@
 // rkcommon
 #include "rkcommon/os/library.h"
 #include "rkcommon/utility/StringManip.h"
+// stl
+#include <mutex>
 
 namespace ospray {
   namespace sg {
@@ -16,19 +18,29 @@ namespace ospray {
 
   Node::Node()
   {
+    static const Symbol defaultName("NULL");
+    static const Symbol defaultSubType("Node");
+    static const Symbol defaultDescription("<no description>");
+
     // NOTE(jda) - can't do default member initializers due to MSVC...
-    properties.name        = "NULL";
+    properties.name        = defaultName;
     properties.type        = NodeType::GENERIC;
-    properties.subType     = "Node";
-    properties.description = "<no description>";
+    properties.subType     = defaultSubType;
+    properties.description = defaultDescription;
     properties.readOnly    = false;
   }
 
   Node::~Node()
   {
     // When destroying a node, remove it from its parents' list of children
-    for (auto &p : properties.parents)
-      p->properties.children.erase(properties.name);
+    for (auto &p : properties.parents) {
+      std::lock_guard<std::mutex> lock(p->properties.linkMutex);
+      p->properties.children.erase(properties.name.str());
+      p->removeDirtyChild(this);
+    }
+    properties.parents.clear();
+    // (no need to unregister each child from the dirty list of a dying node)
+    properties.dirtyChildren.clear();
     // and from all its children's ParentList
     for (auto &c : properties.children)
       c.second->removeFromParentList(*this);
@@ -38,7 +50,7 @@ namespace ospray {
   // Properties ///////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////
 
-  std::string Node::name() const
+  const std::string &Node::name() const
   {
     return properties.name;
   }
@@ -48,12 +60,12 @@ namespace ospray {
     return properties.type;
   }
 
-  std::string Node::subType() const
+  const std::string &Node::subType() const
   {
     return properties.subType;
   }
 
-  std::string Node::description() const
+  const std::string &Node::description() const
   {
     return properties.description;
   }
@@ -69,7 +81,7 @@ namespace ospray {
     properties.origName = origName;
   }
 
-  std::string Node::getOrigName()
+  const std::string &Node::getOrigName()
   {
     return properties.origName;
   }
@@ -92,30 +104,27 @@ namespace ospray {
   // Parent-child structural interface /////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////
 
-  const FlatMap<std::string, NodePtr> &Node::children() const
+  const NodeMap &Node::children() const
   {
     return properties.children;
   }
 
- bool Node::hasChild(const std::string &name) const
+  bool Node::hasChild(const std::string &name) const
   {
-    auto &c = properties.children;
-    if (c.contains(name))
-      return true;
-
-    auto itr = std::find_if(c.cbegin(), c.cend(), [&](const NodeLink &n) {
-      return n.first == name;
-    });
-
-    return itr != properties.children.end();
+    return properties.children.contains(name);
   }
 
   bool Node::hasChildOfSubType(const std::string &subType) const
   {
+    // A subtype that was never interned can't be any node's subtype
+    Symbol symbol;
+    if (!Symbol::lookup(subType, symbol))
+      return false;
+
     auto &c = properties.children;
 
     auto itr = std::find_if(c.cbegin(), c.cend(), [&](const NodeLink &n) {
-      return n.second->subType() == subType;
+      return n.second->properties.subType == symbol;
     });
 
     return itr != properties.children.end();
@@ -135,14 +144,9 @@ namespace ospray {
   Node &Node::child(const std::string &name)
   {
     auto &c = properties.children;
-    if (c.contains(name))
-      return *c[name];
+    auto itr = c.find(name);
 
-    auto itr = std::find_if(c.begin(), c.end(), [&](const NodeLink &n) {
-      return n.first == name;
-    });
-
-    if (itr == properties.children.cend()) {
+    if (itr == c.end()) {
       throw std::runtime_error(
           "in " + subType() + " node '" + this->name() + "'" +
           ": could not find sg child node with name '" + name + "'");
@@ -156,8 +160,12 @@ namespace ospray {
     auto &props = properties.children;
     std::vector<NodePtr> childrenOfType;
 
+    Symbol symbol;
+    if (!Symbol::lookup(subType, symbol))
+      return childrenOfType;
+
     for (auto &p : props) {
-      if (p.second->subType() == subType)
+      if (p.second->properties.subType == symbol)
         childrenOfType.push_back(p.second);
     }
     return childrenOfType;
@@ -212,27 +220,73 @@ namespace ospray {
 
   void Node::add(NodePtr node, const std::string &name)
   {
-    if (hasChild(name)) {
-      if (properties.children[name] == node)
+    NodePtr replaced;
+    bool childDirty = false;
+
+    {
+      std::lock(properties.linkMutex, node->properties.linkMutex);
+      std::lock_guard<std::mutex> lock(properties.linkMutex, std::adopt_lock);
+      std::lock_guard<std::mutex> childLock(
+          node->properties.linkMutex, std::adopt_lock);
+
+      auto &c  = properties.children;
+      auto itr = c.find(name);
+      if (itr != c.end() && itr->second == node)
         return;
-      properties.children[name]->removeFromParentList(*this);
+
+      // Link the parent first, so a throwing insertion leaves no dangling
+      // link behind
+      node->properties.parents.push_back(this);
+      if (itr != c.end()) {
+        replaced    = std::move(itr->second);
+        itr->second = node;
+      } else {
+        try {
+          c.emplace(name, node);
+        } catch (...) {
+          node->properties.parents.pop_back();
+          throw;
+        }
+      }
+
+      childDirty = node->properties.subtreeDirty;
+      if (childDirty)
+        properties.dirtyChildren.emplace(node.get(), true);
     }
-    properties.children[name] = node;
-    node->properties.parents.push_back(this);
+
+    // A child previously added under the same name gets unlinked
+    if (replaced)
+      replaced->removeFromParentList(*this);
+
+    if (childDirty)
+      properties.childrenMTime.renew();
     markAsModified();
   }
 
   void Node::remove(Node &node)
   {
-    for (auto &child : properties.children) {
-      if (child.second.get() == &node) {
-        child.second->removeFromParentList(*this);
-        properties.children.erase(child.first);
-        return;
+    NodePtr removed;
+
+    {
+      std::lock_guard<std::mutex> lock(properties.linkMutex);
+      auto &c = properties.children;
+      // Children are normally linked under their own name, only look further
+      // when they aren't
+      auto itr = c.find(node.name());
+      if (itr == c.end() || itr->second.get() != &node)
+        itr = std::find_if(c.begin(), c.end(), [&](const NodeLink &l) {
+          return l.second.get() == &node;
+        });
+      if (itr != c.end()) {
+        removed = itr->second;
+        c.erase(itr->first);
       }
     }
 
-    markAsModified();
+    if (removed)
+      removed->removeFromParentList(*this);
+    else
+      markAsModified();
   }
 
   void Node::remove(NodePtr node)
@@ -242,36 +296,52 @@ namespace ospray {
 
   void Node::remove(const std::string &name)
   {
-    for (auto &child : properties.children) {
-      if (child.first == name) {
-        child.second->removeFromParentList(*this);
-        properties.children.erase(child.first);
-        return;
+    NodePtr removed;
+
+    {
+      std::lock_guard<std::mutex> lock(properties.linkMutex);
+      auto &c = properties.children;
+      auto itr = c.find(name);
+      if (itr != c.end()) {
+        removed = itr->second;
+        c.erase(itr->first);
       }
     }
 
-    markAsModified();
+    if (removed)
+      removed->removeFromParentList(*this);
+    else
+      markAsModified();
   }
 
   void Node::removeAllParents()
   {
-    for (auto &p : properties.parents)
+    // remove() modifies the parents list, so iterate over a copy
+    std::vector<Node *> parents;
+    {
+      std::lock_guard<std::mutex> lock(properties.linkMutex);
+      parents = properties.parents;
+    }
+
+    for (auto *p : parents)
       p->remove(*this);
   }
 
   void Node::removeAllChildren()
   {
-    for (auto &c : properties.children)
-      remove(c.first);
+    while (hasChildren())
+      remove(std::string(properties.children.crbegin()->first));
   }
 
   /////////////////////////////////////////////////////////////////////////////
   // Traversal Interface ///////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////
 
+  CommitSettings commitSettings;
+
   void Node::commit()
   {
-    traverse<CommitVisitor>();
+    CommitVisitor().commit(*this);
   }
 
   void Node::render()
@@ -282,9 +352,7 @@ namespace ospray {
   
   box3f Node::bounds()
   {
-    GetBounds visitor;
-    traverse(visitor);
-    return visitor.bounds;
+    return GetBounds()(*this);
   }
 
   /////////////////////////////////////////////////////////////////////////////
@@ -378,26 +446,142 @@ namespace ospray {
 
   void Node::removeFromParentList(Node &node)
   {
+    {
+      std::lock(properties.linkMutex, node.properties.linkMutex);
+      std::lock_guard<std::mutex> lock(properties.linkMutex, std::adopt_lock);
+      std::lock_guard<std::mutex> parentLock(
+          node.properties.linkMutex, std::adopt_lock);
+
+      node.removeDirtyChild(this);
+      auto &p          = properties.parents;
+      auto remove_node = [&](auto np) { return np == &node; };
+      p.erase(std::remove_if(p.begin(), p.end(), remove_node), p.end());
+    }
+
     node.markAsModified(); // Removal requires notifying parents
-    auto &p          = properties.parents;
-    auto remove_node = [&](auto np) { return np == &node; };
-    p.erase(std::remove_if(p.begin(), p.end(), remove_node), p.end());
   }
 
   void Node::markAsModified()
   {
-    // Mark all parents, up to root, as modified
     properties.lastModified.renew();
-    for (auto &p : properties.parents)
-      p->updateChildrenModifiedTime();
+    markSubtreeDirty();
+    markBoundsModified();
   }
 
   void Node::updateChildrenModifiedTime()
   {
-    // Notify all parent of latest child modified time
     properties.childrenMTime.renew();
+    markSubtreeDirty();
+  }
+
+  void Node::markCommitted()
+  {
+    properties.lastCommitted.renew();
+
+    // Children modified while this node was being committed (ie. by a
+    // sibling's postCommit()) stay registered, and keep this node dirty for
+    // the next commit.
+    bool stillDirty = false;
+    {
+      std::lock_guard<std::mutex> lock(properties.linkMutex);
+      properties.subtreeDirty = false;
+
+      auto &dc = properties.dirtyChildren;
+      std::vector<Node *> committed;
+      for (auto &c : dc)
+        if (!c.first->properties.subtreeDirty)
+          committed.push_back(c.first);
+      for (auto *c : committed)
+        dc.erase(c);
+      stillDirty = !dc.empty();
+    }
+
+    if (stillDirty)
+      updateChildrenModifiedTime();
+
+    if (properties.boundsCache.fromOSPRay)
+      markBoundsModified();
+  }
+
+  void Node::markSubtreeDirty()
+  {
+    // Register with all parents, up to root, only the first time this
+    // subtree is modified since it was last committed.  Ancestors already
+    // marked dirty need no further notification.
+    //
+    if (properties.subtreeDirty)
+      return;
+
+    // NOTE: parents are locked while this node's lock is held, always in
+    //       child -> parent order, which can't deadlock in an acyclic graph
+    std::lock_guard<std::mutex> lock(properties.linkMutex);
+    if (properties.subtreeDirty)
+      return;
+
+    properties.subtreeDirty = true;
     for (auto &p : properties.parents)
-      p->updateChildrenModifiedTime();
+      p->addDirtyChild(this);
+  }
+
+  void Node::markBoundsModified(Node *child)
+  {
+    auto &cache = properties.boundsCache;
+
+    // Nothing cached since the last modification, parents already know
+    if (!child && !cache.valid && cache.contentModified)
+      return;
+
+    // Like dirty paths, parents are only notified when the cache of a node
+    // gets invalidated, not for every modification
+    std::vector<Node *> parents;
+    {
+      std::lock_guard<std::mutex> lock(properties.linkMutex);
+      if (child)
+        cache.modifiedChildren.push_back(child);
+      else
+        cache.contentModified = true;
+
+      if (cache.valid.exchange(false))
+        parents = properties.parents;
+    }
+
+    for (auto *p : parents)
+      p->markBoundsModified(this);
+  }
+
+  void Node::addDirtyChild(Node *child)
+  {
+    {
+      std::lock_guard<std::mutex> lock(properties.linkMutex);
+      properties.dirtyChildren.emplace(child, true);
+    }
+    updateChildrenModifiedTime();
+  }
+
+  void Node::removeDirtyChild(Node *child)
+  {
+    properties.dirtyChildren.erase(child);
+  }
+
+  std::vector<Node *> Node::modifiedChildren()
+  {
+    std::vector<Node *> dirty;
+    std::lock_guard<std::mutex> lock(properties.linkMutex);
+    dirty.reserve(properties.dirtyChildren.size());
+    for (auto &c : properties.dirtyChildren)
+      dirty.push_back(c.first);
+    return dirty;
+  }
+
+  std::vector<Node *> Node::takeDirtyChildren()
+  {
+    std::vector<Node *> dirty;
+    std::lock_guard<std::mutex> lock(properties.linkMutex);
+    dirty.reserve(properties.dirtyChildren.size());
+    for (auto &c : properties.dirtyChildren)
+      dirty.push_back(c.first);
+    properties.dirtyChildren.clear();
+    return dirty;
   }
 
   void Node::setOSPRayParam(std::string, OSPObject) {}
@@ -406,48 +590,92 @@ namespace ospray {
   // Global Stuff /////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////
 
-  using CreatorFct = Node *(*)();
+  using RawCreatorFct = Node *(*)();
 
-  static std::map<std::string, CreatorFct> nodeRegistry;
+  struct NodeRegistry
+  {
+    std::mutex mutex;
+    std::unordered_map<std::string, NodeCreatorFct> creators;
+    // creators found via getSymbol(), for types not registered at load time
+    std::unordered_map<std::string, RawCreatorFct> rawCreators;
+    bool libraryLoaded{false};
+  };
 
-  std::shared_ptr<Node> createNode(std::string name,
-                                   std::string subtype,
-                                   std::string description,
-                                   Any value)
+  // NOTE: function local static, registrations run during static init
+  static NodeRegistry &nodeRegistry()
   {
-    // Verify that 'ospray_sg' is properly loaded //
+    static NodeRegistry registry;
+    return registry;
+  }
 
-    static bool libraryLoaded = false;
-    if (!libraryLoaded) {
-      loadLibrary("ospray_sg");
-      libraryLoaded = true;
-    }
+  void registerNodeCreator(const std::string &subtype, NodeCreatorFct creator)
+  {
+    auto &registry = nodeRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.creators[subtype] = creator;
+  }
 
-    // Look for the factory function to create the node //
+  static NodePtr createNodeOfSubtype(const std::string &subtype)
+  {
+    // NOTE: creators run without the lock, node constructors create their
+    //       own children
+    NodeCreatorFct creator   = nullptr;
+    RawCreatorFct rawCreator = nullptr;
 
-    auto it = nodeRegistry.find(subtype);
+    {
+      auto &registry = nodeRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
 
-    CreatorFct creator = nullptr;
+      auto it = registry.creators.find(subtype);
+      if (it != registry.creators.end())
+        creator = it->second;
+      else {
+        // Fall back to looking up the factory function by symbol name //
 
-    if (it == nodeRegistry.end()) {
-      std::string creatorName = "ospray_create_sg_node__" + subtype;
+        auto rawIt = registry.rawCreators.find(subtype);
+        if (rawIt == registry.rawCreators.end()) {
+          // Verify that 'ospray_sg' is properly loaded //
+          if (!registry.libraryLoaded) {
+            loadLibrary("ospray_sg");
+            registry.libraryLoaded = true;
+          }
 
-      creator = (CreatorFct)getSymbol(creatorName);
-      if (!creator)
-        throw std::runtime_error("unknown node type '" + subtype + "'");
+          std::string creatorName = "ospray_create_sg_node__" + subtype;
 
-      nodeRegistry[subtype] = creator;
-    } else {
-      creator = it->second;
+          rawCreator = (RawCreatorFct)getSymbol(creatorName);
+          if (!rawCreator)
+            throw std::runtime_error("unknown node type '" + subtype + "'");
+
+          registry.rawCreators[subtype] = rawCreator;
+        } else {
+          rawCreator = rawIt->second;
+        }
+      }
     }
 
-    // Create the node and return //
+    return creator ? creator() : NodePtr(rawCreator());
+  }
+
+  // Everything but the description, which keeps the constructor's default
+  // unless given (saves allocating "<no description>" for every node)
+  NodePtr createNamedNode(std::string &&name, std::string &&subtype)
+  {
+    auto newNode = createNodeOfSubtype(subtype);
+
+    newNode->properties.name    = std::move(name);
+    newNode->properties.subType = std::move(subtype);
+    newNode->properties.type    = newNode->type();
+
+    return newNode;
+  }
 
-    std::shared_ptr<sg::Node> newNode(creator());
-    newNode->properties.name        = name;
-    newNode->properties.subType     = subtype;
-    newNode->properties.type        = newNode->type();
-    newNode->properties.description = description;
+  std::shared_ptr<Node> createNode(std::string name,
+                                   std::string subtype,
+                                   std::string description,
+                                   Any value)
+  {
+    auto newNode = createNamedNode(std::move(name), std::move(subtype));
+    newNode->properties.description = std::move(description);
 
     if (value.valid())
       newNode->setValue(value);
@@ -457,17 +685,22 @@ namespace ospray {
 
   NodePtr createNode(std::string name)
   {
-    return createNode(name, "Node");
+    return createNamedNode(std::move(name), "Node");
   }
 
   NodePtr createNode(std::string name, std::string subtype)
   {
-    return createNode(name, subtype, "<no description>", Any());
+    return createNamedNode(std::move(name), std::move(subtype));
   }
 
   NodePtr createNode(std::string name, std::string subtype, Any value)
   {
-    return createNode(name, subtype, "<no description>", value);
+    auto newNode = createNamedNode(std::move(name), std::move(subtype));
+
+    if (value.valid())
+      newNode->setValue(value);
+
+    return newNode;
   }
 
   OSP_REGISTER_SG_NODE(Node);
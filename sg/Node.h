@@ -5,9 +5,11 @@
 
 #include "Visitor.h"
 // stl
+#include <atomic>
 #include <map>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <vector>
 // rkcommon
 #include "rkcommon/containers/FlatMap.h"
@@ -23,6 +25,10 @@
 // ospray_sg
 #include "version.h"
 #include "NodeType.h"
+#include "HandleMap.h"
+#include "HashedFlatMap.h"
+#include "NodePool.h"
+#include "Symbol.h"
 
 #ifndef OSPSG_INTERFACE
 #ifdef _WIN32
@@ -62,6 +68,9 @@ namespace sg {
   struct Node;
   using NodePtr = std::shared_ptr<Node>;
 
+  // Children are stored in insertion order with a hashed name lookup
+  using NodeMap = HashedFlatMap<std::string, NodePtr>;
+
   struct Data;
 
   struct OSPSG_INTERFACE Node : public std::enable_shared_from_this<Node>
@@ -88,14 +97,14 @@ namespace sg {
 
     // Properties /////////////////////////////////////////////////////////////
 
-    std::string name() const;
+    const std::string &name() const;
     virtual NodeType type() const;
-    std::string subType() const;
-    std::string description() const;
+    const std::string &subType() const;
+    const std::string &description() const;
 
     // original node name(if present) as specified in a scene format file
     void setOrigName(const std::string &origName);
-    std::string getOrigName();
+    const std::string &getOrigName();
 
     size_t uniqueID() const;
 
@@ -120,13 +129,16 @@ namespace sg {
 
     void operator=(Any val);
 
+    template <typename T>
+    void operator=(T val);
+
     // Parent-child structural interface ///////////////////////////////////////
 
     using NodeLink = std::pair<std::string, NodePtr>;
 
     // Children //
 
-    const FlatMap<std::string, NodePtr> &children() const;
+    const NodeMap &children() const;
 
     bool hasChildren() const;
 
@@ -155,6 +167,11 @@ namespace sg {
     bool hasParents() const;
 
     // Structural Changes (add/remove children) //
+    //
+    // NOTE: linking nodes and marking them modified is thread safe, so
+    //       concurrent builders (ie. async importers) may share nodes.  A
+    //       node's children must still not be changed while that node is
+    //       being traversed or committed on another thread.
 
     void add(Node &node);
     void add(Node &node, const std::string &name);
@@ -200,6 +217,7 @@ namespace sg {
     void commit();
     void render();
 
+    // Bounds of this subtree in its parent's space, see GetBounds
     box3f bounds();
 
     virtual void setOSPRayParam(std::string param, OSPObject handle);
@@ -245,10 +263,14 @@ namespace sg {
 
     void markAsModified();
     void updateChildrenModifiedTime();
+    void markCommitted();
 
     bool subtreeModifiedButNotCommitted() const;
     bool anyChildModified() const;
 
+    // The children modified since this node was last committed
+    std::vector<Node *> modifiedChildren();
+
    private:
     //! Use a custom provided node visitor to visit each node
     template <typename VISITOR_T>
@@ -260,11 +282,12 @@ namespace sg {
 
     struct
     {
-      std::string name;
+      // interned, as these mostly repeat across nodes
+      Symbol name;
       NodeType type;
-      std::string subType;
-      std::string description;
-      std::string origName;
+      Symbol subType;
+      Symbol description;
+      Symbol origName;
 
       Any value;
       // vectors allows using length to determine if min/max is set
@@ -277,7 +300,7 @@ namespace sg {
       // Nodes that should not be shown in the UI 
       bool sgNoUI{false};
 
-      FlatMap<std::string, NodePtr> children;
+      NodeMap children;
       std::vector<Node *> parents;
 
       TimeStamp whenCreated;
@@ -285,20 +308,95 @@ namespace sg {
       TimeStamp childrenMTime;
       TimeStamp lastCommitted;
       TimeStamp lastVerified;
+
+      // Children with modified-but-not-committed subtrees, registered once
+      // per modification so commits only need to walk the dirty paths.
+      // Keyed by child so unlinking any of them stays O(1).
+      HashedFlatMap<Node *, bool> dirtyChildren;
+      std::atomic<bool> subtreeDirty{false};
+
+      // Bounds of the subtree when last computed, and what was modified
+      // since (see GetBounds)
+      struct
+      {
+        box3f local; // before the node's own transform
+        box3f bounds;
+        bool fromOSPRay{false}; // changes when committed
+        std::atomic<bool> valid{false};
+        std::atomic<bool> contentModified{true};
+        std::vector<Node *> modifiedChildren;
+      } boundsCache;
+
+      // Guards 'children', 'parents' and 'dirtyChildren' against concurrent
+      // linking (readers of 'children' don't lock, see the note on add())
+      std::mutex linkMutex;
     } properties;
 
     void removeFromParentList(Node &node);
 
+    // Dirty-path tracking, see markAsModified() and CommitVisitor::commit()
+    void markSubtreeDirty();
+    void addDirtyChild(Node *child);
+    void removeDirtyChild(Node *child); // expects linkMutex to be held
+    std::vector<Node *> takeDirtyChildren();
+
+    // Invalidates cached bounds up to the root, see GetBounds
+    void markBoundsModified(Node *child = nullptr);
+
     friend NodePtr OSPSG_INTERFACE createNode(std::string, std::string, std::string, Any);
+    friend NodePtr createNamedNode(std::string &&, std::string &&);
 
     friend struct CommitVisitor;
+    friend struct RenderScene; // compares modification times for updates
+    friend struct GetBounds; // caches bounds per node
   };
 
   // SG Instance Picking //////////////////////////////////////////////////////
 
-  typedef std::unordered_map<OSPInstance, unsigned int> OSPInstanceSGIdMap;
-  typedef std::unordered_map<OSPGeometricModel, unsigned int>
-      OSPGeomModelSGIdMap;
+  // The node an OSPRay instance (the transform placing it) or geometric model
+  // (the geometry) was created for, with its SG id: the id the world gave
+  // the enclosing imported asset (see PickIdAllocator), 0 without.
+  struct PickId
+  {
+    unsigned int sgId{0};
+    std::weak_ptr<Node> node;
+  };
+
+  // Hands out the 24-bit SG ids of one world, unique among the nodes holding
+  // one.  Ids of destroyed nodes are handed out again, 0 once all are in use.
+  struct PickIdAllocator
+  {
+    unsigned int allocate();
+    void release(unsigned int id);
+
+   private:
+    std::mutex mutex;
+    std::vector<unsigned int> freeIds;
+    unsigned int next{1};
+  };
+
+  inline unsigned int PickIdAllocator::allocate()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!freeIds.empty()) {
+      auto id = freeIds.back();
+      freeIds.pop_back();
+      return id;
+    }
+    return next <= 0xffffff ? next++ : 0;
+  }
+
+  inline void PickIdAllocator::release(unsigned int id)
+  {
+    if (!id)
+      return;
+    std::lock_guard<std::mutex> lock(mutex);
+    freeIds.push_back(id);
+  }
+
+  // Maintained by RenderScene as it creates and releases OSPRay objects
+  using OSPInstanceSGIdMap  = HandleMap<OSPInstance, PickId>;
+  using OSPGeomModelSGIdMap = HandleMap<OSPGeometricModel, PickId>;
 
   /////////////////////////////////////////////////////////////////////////////
   // Nodes with a strongly-typed value ////////////////////////////////////////
@@ -409,13 +507,37 @@ namespace sg {
   // Node factory function registration ///////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////
 
+  using NodeCreatorFct = NodePtr (*)();
+
+  // Node and its shared_ptr control block in one pooled allocation
+  template <typename NODE_T>
+  inline NodePtr createPooledNode()
+  {
+    return std::allocate_shared<NODE_T>(PoolAllocator<NODE_T>());
+  }
+
+  OSPSG_INTERFACE void registerNodeCreator(const std::string &subtype,
+                                           NodeCreatorFct creator);
+
+  // Registers a creator in the hashed factory registry at library load time
+  struct NodeCreatorRegistration
+  {
+    NodeCreatorRegistration(const char *subtype, NodeCreatorFct creator)
+    {
+      registerNodeCreator(subtype, creator);
+    }
+  };
+
+  // NOTE: the extern "C" creator is kept so node types of libraries that
+  //       weren't registered at load time are still found via getSymbol()
 #define OSP_REGISTER_SG_NODE_NAME(InternalClassName, Name)                     \
   extern "C" OSPSG_DLLEXPORT ospray::sg::Node *ospray_create_sg_node__##Name() \
   {                                                                            \
     return new InternalClassName;                                              \
   }                                                                            \
-  /* Extra declaration to avoid "extra ;" pedantic warnings */                 \
-  ospray::sg::Node *ospray_create_sg_node__##Name()
+  /* Trailing declaration also avoids "extra ;" pedantic warnings */           \
+  static ospray::sg::NodeCreatorRegistration ospray_register_sg_node__##Name(  \
+      #Name, ospray::sg::createPooledNode<InternalClassName>)
 
 #define OSP_REGISTER_SG_NODE(InternalClassName) \
   OSP_REGISTER_SG_NODE_NAME(InternalClassName, InternalClassName)
@@ -62,9 +62,38 @@ namespace ospray {
     }
   }
 
+  namespace detail {
+
+  template <typename T>
+  inline traits::HasOperatorEquals<T, bool> sameValue(const T &a, const T &b)
+  {
+    return a == b;
+  }
+
+  template <typename T>
+  inline traits::NoOperatorEquals<T, bool> sameValue(const T &, const T &)
+  {
+    return false; // same as Any::operator==() for types without '=='
+  }
+
+  } // namespace detail
+
   template <typename T>
   inline void Node::setValue(T val, bool markModified)
   {
+    // Already holding a T, overwrite it in place.  This avoids allocating a
+    // temporary Any (and another one on assignment) plus the virtual compare,
+    // which matters for the per-frame updates of parameter nodes.
+    if (properties.value.is<T>()) {
+      auto &current = properties.value.get<T>();
+      if (!detail::sameValue(current, val)) {
+        current = std::move(val);
+        if (markModified)
+          markAsModified();
+      }
+      return;
+    }
+
     setValue(Any(val), markModified);
   }
 
@@ -127,6 +156,12 @@ namespace ospray {
     setValue(v);
   }
 
+  template <typename T>
+  inline void Node::operator=(T v)
+  {
+    setValue(std::move(v));
+  }
+
   template <typename... Args>
   inline Node &Node::createChild(Args &&... args)
   {
@@ -249,7 +284,7 @@ namespace ospray {
   template <typename OT>
   inline void Node_T<VALUE_T>::operator=(OT &&val)
   {
-    Node::operator=(static_cast<VALUE_T>(val));
+    Node::setValue(static_cast<VALUE_T>(val));
   }
 
   template <typename VALUE_T>
@@ -0,0 +1,130 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// stl
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace ospray {
+  namespace sg {
+
+  // Free-list pool of fixed size blocks.  Memory is carved out of chunks that
+  // grow geometrically (so rarely created node types stay cheap) and is only
+  // recycled within the pool, never handed back to the system.
+  //
+  // NOTE: instances are intentionally leaked (see instance()), nodes held by
+  //       static NodePtrs may still be released after static destruction.
+  template <size_t SIZE, size_t ALIGN>
+  struct FixedSizePool
+  {
+    static FixedSizePool &instance()
+    {
+      static auto *pool = new FixedSizePool;
+      return *pool;
+    }
+
+    void *allocate()
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!freeList)
+        grow();
+      auto *block = freeList;
+      freeList    = block->next;
+      return block;
+    }
+
+    void deallocate(void *p)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto *block = static_cast<Block *>(p);
+      block->next = freeList;
+      freeList    = block;
+    }
+
+   private:
+    union Block
+    {
+      Block *next;
+      alignas(ALIGN) unsigned char storage[SIZE];
+    };
+
+    static constexpr size_t maxChunkBytes = 64 * 1024;
+
+    FixedSizePool() = default;
+
+    void grow()
+    {
+      auto *chunk = static_cast<Block *>(
+          ::operator new(nextChunkSize * sizeof(Block)));
+      chunks.push_back(chunk);
+
+      for (size_t i = 0; i < nextChunkSize; i++) {
+        chunk[i].next = freeList;
+        freeList      = &chunk[i];
+      }
+
+      nextChunkSize = std::max(nextChunkSize,
+          std::min(nextChunkSize * 2, maxChunkBytes / sizeof(Block)));
+    }
+
+    std::mutex mutex;
+    Block *freeList{nullptr};
+    size_t nextChunkSize{4};
+    std::vector<Block *> chunks;
+  };
+
+  // Minimal std allocator on top of FixedSizePool<>, meant for
+  // std::allocate_shared<>() so a node and its shared_ptr control block live
+  // in a single pooled block.
+  template <typename T>
+  struct PoolAllocator
+  {
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &)
+    {}
+
+    T *allocate(size_t n)
+    {
+      if (n != 1)
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+      return static_cast<T *>(pool().allocate());
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+      if (n != 1)
+        ::operator delete(p);
+      else
+        pool().deallocate(p);
+    }
+
+   private:
+    static FixedSizePool<sizeof(T), alignof(T)> &pool()
+    {
+      return FixedSizePool<sizeof(T), alignof(T)>::instance();
+    }
+  };
+
+  template <typename T, typename U>
+  inline bool operator==(const PoolAllocator<T> &, const PoolAllocator<U> &)
+  {
+    return true;
+  }
+
+  template <typename T, typename U>
+  inline bool operator!=(const PoolAllocator<T> &, const PoolAllocator<U> &)
+  {
+    return false;
+  }
+
+  }  // namespace sg
+} // namespace ospray
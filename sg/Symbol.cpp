@@ -0,0 +1,90 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "Symbol.h"
+// stl
+#include <mutex>
+#include <unordered_set>
+
+namespace ospray {
+  namespace sg {
+
+  // The table is split into shards with their own lock, so concurrent
+  // builders (ie. async importers) rarely contend on interning
+  struct SymbolTable
+  {
+    static constexpr size_t numShards = 16;
+
+    struct Shard
+    {
+      std::mutex mutex;
+      std::unordered_set<std::string> strings;
+    };
+
+    Shard &shardOf(const std::string &str)
+    {
+      return shards[std::hash<std::string>()(str) % numShards];
+    }
+
+    Shard shards[numShards];
+  };
+
+  // NOTE: intentionally leaked, nodes in static storage may still use their
+  //       Symbols during static destruction
+  static SymbolTable &symbolTable()
+  {
+    static auto *table = new SymbolTable;
+    return *table;
+  }
+
+  static const std::string *intern(const std::string &str)
+  {
+    auto &shard = symbolTable().shardOf(str);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return &*shard.strings.insert(str).first;
+  }
+
+  Symbol::Symbol()
+  {
+    static const std::string *emptyString = intern("");
+    value = emptyString;
+  }
+
+  Symbol::Symbol(const std::string &str) : value(intern(str)) {}
+
+  Symbol::Symbol(const char *str) : value(intern(str)) {}
+
+  bool Symbol::lookup(const std::string &str, Symbol &symbol)
+  {
+    auto &shard = symbolTable().shardOf(str);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto itr = shard.strings.find(str);
+    if (itr == shard.strings.end())
+      return false;
+
+    symbol.value = &*itr;
+    return true;
+  }
+
+  Symbol::Stats Symbol::stats()
+  {
+    Stats stats;
+
+    for (auto &shard : symbolTable().shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      stats.numSymbols += shard.strings.size();
+      stats.numBytes += shard.strings.bucket_count() * sizeof(void *);
+      for (auto &s : shard.strings) {
+        // hash node (next pointer + cached hash) plus any heap buffer
+        stats.numBytes += sizeof(s) + 2 * sizeof(void *);
+        if (s.capacity() > std::string().capacity())
+          stats.numBytes += s.capacity() + 1;
+      }
+    }
+
+    return stats;
+  }
+
+  }  // namespace sg
+} // namespace ospray
@@ -0,0 +1,95 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+// stl
+#include <string>
+
+#ifndef OSPSG_INTERFACE
+#ifdef _WIN32
+#ifdef ospray_sg_EXPORTS
+#define OSPSG_INTERFACE __declspec(dllexport)
+#else
+#define OSPSG_INTERFACE __declspec(dllimport)
+#endif
+#define OSPSG_DLLEXPORT __declspec(dllexport)
+#else
+#define OSPSG_INTERFACE
+#define OSPSG_DLLEXPORT
+#endif
+#endif
+
+namespace ospray {
+  namespace sg {
+
+  // An interned, immutable string.  All equal strings share a single entry
+  // of a global table, so a Symbol is the size of a pointer and compares by
+  // address.  Used for the node names, subtypes and descriptions, which are
+  // mostly repeated across the (potentially millions of) nodes of a scene.
+  //
+  // NOTE: interned strings are never released.
+  struct OSPSG_INTERFACE Symbol
+  {
+    Symbol(); // the empty string
+    Symbol(const std::string &str);
+    Symbol(const char *str);
+
+    const std::string &str() const;
+    const char *c_str() const;
+    bool empty() const;
+
+    operator const std::string &() const;
+
+    bool operator==(const Symbol &other) const;
+    bool operator!=(const Symbol &other) const;
+
+    // Find the Symbol of an already interned string, without interning it
+    static bool lookup(const std::string &str, Symbol &symbol);
+
+    struct Stats
+    {
+      size_t numSymbols{0};
+      size_t numBytes{0}; // approximate, including table overhead
+    };
+
+    static Stats stats();
+
+   private:
+    const std::string *value;
+  };
+
+  // Inlined definitions //////////////////////////////////////////////////////
+
+  inline const std::string &Symbol::str() const
+  {
+    return *value;
+  }
+
+  inline const char *Symbol::c_str() const
+  {
+    return value->c_str();
+  }
+
+  inline bool Symbol::empty() const
+  {
+    return value->empty();
+  }
+
+  inline Symbol::operator const std::string &() const
+  {
+    return *value;
+  }
+
+  inline bool Symbol::operator==(const Symbol &other) const
+  {
+    return value == other.value;
+  }
+
+  inline bool Symbol::operator!=(const Symbol &other) const
+  {
+    return value != other.value;
+  }
+
+  }  // namespace sg
+} // namespace ospray
@@ -0,0 +1,62 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "bench_common.h"
+
+#include "sg/JSONDefs.h"
+
+using namespace sg_bench;
+
+// Serialize a (depth, width) tree to JSON
+static void BM_JSON_toJSON(benchmark::State &state)
+{
+  auto root = makeSyntheticTree(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    JSON j = *root;
+    benchmark::DoNotOptimize(j);
+  }
+
+  state.SetItemsProcessed(
+      state.iterations() * treeSize(state.range(0), state.range(1)));
+}
+
+// Recreate the tree from its JSON
+static void BM_JSON_createNodeFromJSON(benchmark::State &state)
+{
+  auto root = makeSyntheticTree(state.range(0), state.range(1));
+  JSON j    = *root;
+
+  for (auto _ : state) {
+    auto node = createNodeFromJSON(j);
+    benchmark::DoNotOptimize(node);
+  }
+
+  state.SetItemsProcessed(
+      state.iterations() * treeSize(state.range(0), state.range(1)));
+}
+
+// Full round trip through a string, as when saving and loading a .sg file
+static void BM_JSON_roundTrip(benchmark::State &state)
+{
+  auto root = makeSyntheticTree(state.range(0), state.range(1));
+
+  size_t numBytes = 0;
+  for (auto _ : state) {
+    JSON j    = *root;
+    auto text = j.dump();
+    auto node = createNodeFromJSON(JSON::parse(text));
+    benchmark::DoNotOptimize(node);
+    numBytes += text.size();
+  }
+
+  state.SetItemsProcessed(
+      state.iterations() * treeSize(state.range(0), state.range(1)));
+  state.SetBytesProcessed(numBytes);
+}
+
+BENCHMARK(BM_JSON_toJSON)->Apply(treeShapes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JSON_createNodeFromJSON)
+    ->Apply(treeShapes)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_JSON_roundTrip)->Apply(treeShapes)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,390 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.h>
+
+#include "sg/Node.h"
+#include "sg/visitors/Commit.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+using namespace ospray::sg;
+
+// Count heap allocations and live bytes, reported by the benchmarks ///////////
+
+static std::atomic<size_t> numAllocations{0};
+static std::atomic<int64_t> numLiveBytes{0};
+
+// each block remembers its size in front of it, for operator delete
+static constexpr size_t sizeHeader = 16;
+
+void *operator new(size_t size)
+{
+  numAllocations++;
+  numLiveBytes += size;
+  if (auto *p = static_cast<char *>(std::malloc(size + sizeHeader))) {
+    *reinterpret_cast<size_t *>(p) = size;
+    return p + sizeHeader;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+  if (!p)
+    return;
+  auto *block = static_cast<char *>(p) - sizeHeader;
+  numLiveBytes -= *reinterpret_cast<size_t *>(block);
+  std::free(block);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+// Helpers ////////////////////////////////////////////////////////////////////
+
+static std::vector<NodePtr> makeChildren(int64_t numChildren)
+{
+  std::vector<NodePtr> children;
+  children.reserve(numChildren);
+  for (int64_t i = 0; i < numChildren; i++)
+    children.push_back(createNode("child_" + std::to_string(i), "int", int(i)));
+  return children;
+}
+
+static std::vector<std::string> shuffledNames(int64_t numChildren)
+{
+  std::vector<std::string> names;
+  names.reserve(numChildren);
+  for (int64_t i = 0; i < numChildren; i++)
+    names.push_back("child_" + std::to_string(i));
+  std::shuffle(names.begin(), names.end(), std::mt19937(42));
+  return names;
+}
+
+// Balanced tree of float leaves, returns the root and collects the leaves
+static NodePtr makeTree(
+    int64_t numLeaves, int64_t fanout, std::vector<NodePtr> &leaves)
+{
+  std::vector<NodePtr> level;
+  level.reserve(numLeaves);
+  for (int64_t i = 0; i < numLeaves; i++)
+    level.push_back(createNode("leaf_" + std::to_string(i), "float", 0.f));
+  leaves = level;
+
+  while (level.size() > 1) {
+    std::vector<NodePtr> parents;
+    for (size_t i = 0; i < level.size(); i += fanout) {
+      auto group = createNode("group_" + std::to_string(parents.size()));
+      for (size_t j = i; j < std::min(level.size(), size_t(i + fanout)); j++)
+        group->add(level[j]);
+      parents.push_back(group);
+    }
+    level.swap(parents);
+  }
+
+  return level.front();
+}
+
+// Benchmarks /////////////////////////////////////////////////////////////////
+
+// Cost of adding N children to a single parent
+static void BM_Node_add(benchmark::State &state)
+{
+  const auto numChildren = state.range(0);
+  auto children = makeChildren(numChildren);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto parent = createNode("parent");
+    state.ResumeTiming();
+
+    for (auto &c : children)
+      parent->add(c);
+
+    state.PauseTiming();
+    parent = nullptr; // also unlinks the children for the next iteration
+    state.ResumeTiming();
+  }
+
+  state.SetItemsProcessed(state.iterations() * numChildren);
+  state.SetComplexityN(numChildren);
+}
+
+// Cost of removing, in random order, the N children of a single parent
+static void BM_Node_remove(benchmark::State &state)
+{
+  const auto numChildren = state.range(0);
+  auto children = makeChildren(numChildren);
+  auto names = shuffledNames(numChildren);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto parent = createNode("parent");
+    for (auto &c : children)
+      parent->add(c);
+    state.ResumeTiming();
+
+    for (auto &n : names)
+      parent->remove(n);
+  }
+
+  state.SetItemsProcessed(state.iterations() * numChildren);
+  state.SetComplexityN(numChildren);
+}
+
+// Cost of a by-name lookup (Node::child()) on a parent with N children
+static void BM_Node_child(benchmark::State &state)
+{
+  const auto numChildren = state.range(0);
+  auto parent = createNode("parent");
+  auto children = makeChildren(numChildren);
+  for (auto &c : children)
+    parent->add(c);
+
+  auto names = shuffledNames(numChildren);
+  size_t i = 0;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(&parent->child(names[i]));
+    if (++i == names.size())
+      i = 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetComplexityN(numChildren);
+}
+
+// Cost of Node::hasChild() misses on a parent with N children
+static void BM_Node_hasChild_miss(benchmark::State &state)
+{
+  const auto numChildren = state.range(0);
+  auto parent = createNode("parent");
+  auto children = makeChildren(numChildren);
+  for (auto &c : children)
+    parent->add(c);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(parent->hasChild("not_a_child"));
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetComplexityN(numChildren);
+}
+
+// Commit after changing a single leaf in a tree of N leaves (range(0)) with
+// the given fanout (range(1))
+static void BM_Node_commit_oneDirty(benchmark::State &state)
+{
+  std::vector<NodePtr> leaves;
+  auto root = makeTree(state.range(0), state.range(1), leaves);
+  root->commit();
+
+  size_t i = 0;
+  float v = 0.f;
+  for (auto _ : state) {
+    leaves[i]->setValue(v += 1.f);
+    root->commit();
+    i = (i + 7919) % leaves.size();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Same, but with a full tree walk of the CommitVisitor
+static void BM_Node_commit_oneDirty_traverse(benchmark::State &state)
+{
+  std::vector<NodePtr> leaves;
+  auto root = makeTree(state.range(0), state.range(1), leaves);
+  root->commit();
+
+  size_t i = 0;
+  float v = 0.f;
+  for (auto _ : state) {
+    leaves[i]->setValue(v += 1.f);
+    root->traverse<CommitVisitor>();
+    i = (i + 7919) % leaves.size();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// A node standing in for real per-node commit work (ie. ospCommit())
+struct BusyNode : public Node
+{
+  void postCommit() override
+  {
+    float x = valueAs<float>();
+    for (int i = 0; i < 2000; i++)
+      x = x * 0.999f + 1.f;
+    benchmark::DoNotOptimize(x);
+  }
+};
+
+// Commit after changing every busy leaf below N (range(0)) sibling groups
+// of 64 leaves each, serially (range(1) == 0) or in parallel
+static void BM_Node_commit_allDirty(benchmark::State &state)
+{
+  auto root = createNode("root");
+  std::vector<NodePtr> leaves;
+  for (int64_t g = 0; g < state.range(0); g++) {
+    auto &group = root->createChild("group_" + std::to_string(g));
+    for (int l = 0; l < 64; l++) {
+      auto leaf = std::make_shared<BusyNode>();
+      leaf->setValue(float(l));
+      group.add(leaf, "leaf_" + std::to_string(l));
+      leaves.push_back(leaf);
+    }
+  }
+  root->commit();
+
+  auto parallel = commitSettings.parallel;
+  commitSettings.parallel = state.range(1) != 0;
+
+  float v = 0.f;
+  for (auto _ : state) {
+    v += 1.f;
+    for (auto &l : leaves)
+      l->setValue(v);
+    root->commit();
+  }
+
+  commitSettings.parallel = parallel;
+  state.SetItemsProcessed(state.iterations() * leaves.size());
+}
+
+// Heap footprint of a scene shaped like an imported one: N (range(0))
+// objects, each a transform with the parameter children of sg::Transform
+// above a mesh with those of sg::Geometry
+static void BM_Node_sceneFootprint(benchmark::State &state)
+{
+  for (auto _ : state) {
+    auto liveBefore = numLiveBytes.load();
+
+    auto world = createNode("world");
+    size_t numNodes = 1;
+    for (int64_t i = 0; i < state.range(0); i++) {
+      auto xfm = createNode("xfm_" + std::to_string(i));
+      xfm->createChild("translation", "vec3f", vec3f(zero));
+      xfm->createChild("rotation", "quaternionf", quaternionf(one));
+      xfm->createChild("scale", "vec3f", vec3f(one));
+      xfm->createChild("dynamicScene",
+          "bool",
+          "faster BVH build, slower ray traversal",
+          false);
+      xfm->createChild("compactMode",
+          "bool",
+          "tell Embree to use a more compact BVH in memory by trading ray "
+          "traversal performance",
+          false);
+      xfm->createChild("robustMode",
+          "bool",
+          "tell Embree to enable more robust ray intersection code "
+          "paths(slightly slower)",
+          false);
+
+      auto mesh = createNode("mesh_" + std::to_string(i));
+      mesh->createChild("isClipping", "bool", false);
+      mesh->createChild("visible", "bool", true);
+      mesh->createChild("invertNormals", "bool", false);
+
+      xfm->add(mesh);
+      world->add(xfm);
+      numNodes += 11;
+    }
+
+    state.counters["nodes"] = numNodes;
+    state.counters["bytesPerNode"] =
+        double(numLiveBytes - liveBefore) / numNodes;
+  }
+
+  auto symbols = Symbol::stats();
+  state.counters["symbols"] = symbols.numSymbols;
+  state.counters["symbolBytes"] = symbols.numBytes;
+}
+
+// Create (and release) nodes of the given subtype
+static void BM_createNode(benchmark::State &state, const char *subtype)
+{
+  std::vector<NodePtr> nodes(1024);
+  auto allocsBefore = numAllocations.load();
+
+  size_t i = 0;
+  for (auto _ : state) {
+    nodes[i] = createNode("node", subtype);
+    i = (i + 1) % nodes.size();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["allocs"] = benchmark::Counter(
+      numAllocations - allocsBefore, benchmark::Counter::kAvgIterations);
+}
+
+// Alternately set two different values on a node already holding a T
+template <typename T>
+static void BM_Node_setValue(benchmark::State &state, T a, T b)
+{
+  auto node = createNode("value", "Node", a);
+  auto allocsBefore = numAllocations.load();
+
+  bool flip = false;
+  for (auto _ : state) {
+    node->setValue((flip = !flip) ? b : a);
+    benchmark::ClobberMemory();
+  }
+
+  state.counters["allocs"] = benchmark::Counter(
+      numAllocations - allocsBefore, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_CAPTURE(BM_createNode, Node, "Node");
+BENCHMARK_CAPTURE(BM_createNode, float, "float");
+BENCHMARK_CAPTURE(BM_createNode, affine3f, "affine3f");
+
+BENCHMARK_CAPTURE(BM_Node_setValue, float, 1.f, 2.f);
+BENCHMARK_CAPTURE(BM_Node_setValue, vec3f, vec3f(1.f), vec3f(2.f));
+BENCHMARK_CAPTURE(BM_Node_setValue,
+    affine3f,
+    affine3f(one),
+    affine3f::translate(vec3f(1.f)));
+BENCHMARK_CAPTURE(BM_Node_setValue,
+    quaternionf,
+    quaternionf(one),
+    quaternionf(0.f, 1.f, 0.f, 0.f));
+
+BENCHMARK(BM_Node_add)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+BENCHMARK(BM_Node_remove)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000)
+    ->Unit(benchmark::kMillisecond)
+    ->Complexity();
+BENCHMARK(BM_Node_child)->RangeMultiplier(10)->Range(10, 100000)->Complexity();
+BENCHMARK(BM_Node_hasChild_miss)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000)
+    ->Complexity();
+BENCHMARK(BM_Node_commit_oneDirty)
+    ->Args({1 << 12, 16})
+    ->Args({1 << 19, 16})
+    ->Args({1 << 16, 1 << 16});
+BENCHMARK(BM_Node_commit_oneDirty_traverse)
+    ->Args({1 << 12, 16})
+    ->Args({1 << 19, 16})
+    ->Args({1 << 16, 1 << 16});
+BENCHMARK(BM_Node_commit_allDirty)
+    ->ArgsProduct({{16, 256}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_Node_sceneFootprint)
+    ->Arg(100000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
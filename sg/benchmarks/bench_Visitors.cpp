@@ -0,0 +1,352 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "bench_common.h"
+
+#include "sg/scene/geometry/Geometry.h"
+#include "sg/visitors/Commit.h"
+#include "sg/visitors/RenderScene.h"
+// stl
+#include <cmath>
+
+using namespace sg_bench;
+
+// Helpers ////////////////////////////////////////////////////////////////////
+
+// Visits every node, doing nothing else
+struct NoOpVisitor : public Visitor
+{
+  bool operator()(Node &, TraversalContext &) override
+  {
+    numVisited++;
+    return true;
+  }
+
+  size_t numVisited{0};
+};
+
+// Position of transform 'i' in a cube grid of 'n' transforms
+static vec3f gridPosition(int64_t i, int64_t n)
+{
+  const int64_t side = std::max(int64_t(std::cbrt(double(n))), int64_t(1));
+  return vec3f(
+      float(i % side), float(i / side % side), float(i / side / side));
+}
+
+// Offset within a grid cell, differing for each visit of the same transform
+// when stepping through them by a prime
+static float jitter(size_t step)
+{
+  return 0.25f * (step % 251) / 251.f;
+}
+
+// World of 'n' transforms, on a grid, instancing one shared sphere geometry
+static NodePtr makeInstancedWorld(int64_t n, std::vector<NodePtr> &xfms)
+{
+  auto world = createNode("world", "world");
+
+  auto spheres = createNodeAs<Geometry>("spheres", "geometry_spheres");
+  spheres->positions.push_back(vec3f(0.f));
+  spheres->createChildData("sphere.position", spheres->positions, true);
+  spheres->createChild("material", "uint32_t", (uint32_t)0);
+  spheres->child("material").setSGOnly();
+
+  for (int64_t i = 0; i < n; i++) {
+    auto xfm = createNode("xfm_" + std::to_string(i), "transform");
+    xfm->child("translation") = gridPosition(i, n);
+    xfm->add(spheres);
+    world->add(xfm);
+    xfms.push_back(xfm);
+  }
+
+  return world;
+}
+
+// Benchmarks /////////////////////////////////////////////////////////////////
+
+// Full traversal of a (depth, width) tree with a visitor doing nothing
+static void BM_traverse_noOp(benchmark::State &state)
+{
+  auto root = makeSyntheticTree(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    NoOpVisitor visitor;
+    root->traverse(visitor);
+    benchmark::DoNotOptimize(visitor.numVisited);
+  }
+
+  state.SetItemsProcessed(
+      state.iterations() * treeSize(state.range(0), state.range(1)));
+}
+
+// Commit of an already committed tree
+static void BM_commit_clean(benchmark::State &state)
+{
+  auto root = makeSyntheticTree(state.range(0), state.range(1));
+  root->commit();
+
+  for (auto _ : state)
+    root->commit();
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Same, with a full tree walk of the CommitVisitor
+static void BM_commit_clean_traverse(benchmark::State &state)
+{
+  auto root = makeSyntheticTree(state.range(0), state.range(1));
+  root->commit();
+
+  for (auto _ : state)
+    root->traverse<CommitVisitor>();
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Commit after modifying a single leaf
+static void BM_commit_dirtyLeaf(benchmark::State &state)
+{
+  std::vector<NodePtr> leaves;
+  auto root = makeSyntheticTree(state.range(0), state.range(1), &leaves);
+  root->commit();
+
+  size_t i = 0;
+  for (auto _ : state) {
+    touchLeaf(*leaves[i]);
+    root->commit();
+    i = (i + 7919) % leaves.size();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Commit after modifying every leaf
+static void BM_commit_dirtyAll(benchmark::State &state)
+{
+  std::vector<NodePtr> leaves;
+  auto root = makeSyntheticTree(state.range(0), state.range(1), &leaves);
+  root->commit();
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (auto &l : leaves)
+      touchLeaf(*l);
+    state.ResumeTiming();
+
+    root->commit();
+  }
+
+  state.SetItemsProcessed(
+      state.iterations() * treeSize(state.range(0), state.range(1)));
+}
+
+// Commit of a world of N (range(0)) transforms instancing one shared sphere
+// geometry, after moving one of them a bit.  World::postCommit() runs
+// RenderScene.
+static void BM_RenderScene_moveOne(benchmark::State &state)
+{
+  NodePtr world;
+  std::vector<NodePtr> xfms;
+
+  try {
+    world = makeInstancedWorld(state.range(0), xfms);
+    world->commit();
+  } catch (const std::exception &e) {
+    state.SkipWithError(e.what());
+    return;
+  }
+
+  size_t i = 0, step = 0;
+  for (auto _ : state) {
+    xfms[i]->child("translation") =
+        gridPosition(i, xfms.size()) + vec3f(0.f, jitter(step++), 0.f);
+    world->commit();
+    i = (i + 7919) % xfms.size();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Same as BM_RenderScene_moveOne, but setting the transform's own value like
+// importers and scripts do, rather than its translation
+static void BM_RenderScene_setOne(benchmark::State &state)
+{
+  NodePtr world;
+  std::vector<NodePtr> xfms;
+
+  try {
+    world = makeInstancedWorld(state.range(0), xfms);
+    world->commit();
+  } catch (const std::exception &e) {
+    state.SkipWithError(e.what());
+    return;
+  }
+
+  size_t i = 0, step = 0;
+  for (auto _ : state) {
+    xfms[i]->setValue(affine3f::translate(vec3f(0.f, jitter(step++), 0.f)));
+    world->commit();
+    i = (i + 7919) % xfms.size();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Bounds of the same world after moving one of its transforms a bit, with
+// and without committing in between (range(1)).  Transforms on the outside
+// of the grid define the bounds, moving those merges all transforms again.
+static void BM_GetBounds_moveOne(benchmark::State &state)
+{
+  NodePtr world;
+  std::vector<NodePtr> xfms;
+
+  try {
+    world = makeInstancedWorld(state.range(0), xfms);
+    world->commit();
+  } catch (const std::exception &e) {
+    state.SkipWithError(e.what());
+    return;
+  }
+
+  const bool commit = state.range(1);
+  size_t i = 0, step = 0;
+  for (auto _ : state) {
+    xfms[i]->child("translation") =
+        gridPosition(i, xfms.size()) + vec3f(0.f, jitter(step++), 0.f);
+    if (commit) {
+      state.PauseTiming();
+      world->commit();
+      state.ResumeTiming();
+    }
+    benchmark::DoNotOptimize(world->bounds());
+    i = (i + 7919) % xfms.size();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Commit of a skinned character, after posing it, with RenderScene skinning
+// its mesh.  The character is a tube of range(0) vertices around a chain of
+// 64 joints, each vertex weighted to the 4 nearest joints like imported glTF
+// meshes.  range(1) == 1 adds motion blur, skinning the end pose as well.
+static void BM_RenderScene_skinning(benchmark::State &state)
+{
+  const int numJoints = 64;
+  const size_t numVertices = state.range(0);
+  const size_t segments = 256;
+  const size_t rings = numVertices / segments;
+  const float jointLength = 1.f;
+  const float height = numJoints * jointLength;
+
+  NodePtr world;
+  std::vector<NodePtr> jointXfms;
+
+  try {
+    world = createNode("world", "world");
+    auto character = createNode("character", "transform");
+    world->add(character);
+
+    auto skin = std::make_shared<Skin>();
+    auto *parent = character.get();
+    for (int j = 0; j < numJoints; j++) {
+      auto joint = createNode("joint_" + std::to_string(j), "transform");
+      joint->child("translation") = vec3f(0.f, j ? jointLength : 0.f, 0.f);
+      parent->add(joint);
+      parent = joint.get();
+
+      skin->joints.push_back(joint);
+      skin->inverseBindMatrices.push_back(
+          affine3f::translate(vec3f(0.f, -j * jointLength, 0.f)));
+      jointXfms.push_back(joint);
+    }
+
+    auto mesh = createNode("mesh", "geometry_triangles");
+    auto geom = mesh->nodeAs<Geometry>();
+    geom->skin = skin;
+    geom->skeletonRoot = character;
+    geom->weightsPerVertex = 4;
+
+    for (size_t r = 0; r < rings; r++) {
+      const float y = height * r / (rings - 1);
+      // joints around the vertex, with weights falling off with distance
+      const int nearest = std::min(int(y / jointLength), numJoints - 1);
+      float weights[4], sum = 0.f;
+      int joints[4];
+      for (int k = 0; k < 4; k++) {
+        joints[k] = std::max(0, std::min(nearest + k - 1, numJoints - 1));
+        weights[k] = 1.f / (1.f + std::abs(y - joints[k] * jointLength));
+        sum += weights[k];
+      }
+
+      for (size_t s = 0; s < segments; s++) {
+        const float phi = 2.f * float(M_PI) * s / segments;
+        const vec3f n(std::cos(phi), 0.f, std::sin(phi));
+        geom->positions.push_back(n * 0.25f + vec3f(0.f, y, 0.f));
+        geom->normals.push_back(n);
+        for (int k = 0; k < 4; k++) {
+          geom->joints.push_back(joints[k]);
+          geom->weights.push_back(weights[k] / sum);
+        }
+        if (r + 1 < rings) {
+          const uint32_t v0 = r * segments + s;
+          const uint32_t v1 = r * segments + (s + 1) % segments;
+          geom->vi.push_back(vec3ui(v0, v1, v1 + segments));
+          geom->vi.push_back(vec3ui(v0, v1 + segments, v0 + segments));
+        }
+      }
+    }
+
+    geom->skinnedPositions = geom->positions;
+    geom->skinnedNormals = geom->normals;
+    mesh->createChildData("vertex.position", geom->skinnedPositions, true);
+    mesh->createChildData("vertex.normal", geom->skinnedNormals, true);
+    mesh->createChildData("index", geom->vi, true);
+    mesh->createChild("material", "uint32_t", (uint32_t)0);
+    mesh->child("material").setSGOnly();
+    character->add(mesh);
+
+    if (state.range(1))
+      jointXfms[0]->child("translation").createChild(
+          "endKey", "vec3f", vec3f(0.f, 0.f, 0.1f));
+
+    world->commit();
+  } catch (const std::exception &e) {
+    state.SkipWithError(e.what());
+    return;
+  }
+
+  float angle = 0.f;
+  for (auto _ : state) {
+    // bend the whole chain a bit further
+    angle += 0.001f;
+    for (auto &joint : jointXfms)
+      joint->child("rotation") =
+          quaternionf::rotate(vec3f(0.f, 0.f, 1.f), angle);
+    world->commit();
+  }
+
+  state.SetItemsProcessed(state.iterations() * rings * segments);
+}
+
+BENCHMARK(BM_traverse_noOp)->Apply(treeShapes);
+BENCHMARK(BM_commit_clean)->Apply(treeShapes);
+BENCHMARK(BM_commit_clean_traverse)->Apply(treeShapes);
+BENCHMARK(BM_commit_dirtyLeaf)->Apply(treeShapes);
+BENCHMARK(BM_commit_dirtyAll)->Apply(treeShapes);
+BENCHMARK(BM_RenderScene_moveOne)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RenderScene_setOne)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_GetBounds_moveOne)
+    ->ArgsProduct({{1000, 100000}, {0, 1}})
+    ->ArgNames({"transforms", "committed"})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RenderScene_skinning)
+    ->ArgsProduct({{1 << 16, 1 << 20}, {0, 1}})
+    ->ArgNames({"vertices", "motionBlur"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
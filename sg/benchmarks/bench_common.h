@@ -0,0 +1,113 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include "sg/Node.h"
+
+// stl
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Synthetic trees ////////////////////////////////////////////////////////////
+//
+// Tree benchmarks take (depth, width) as their arguments.  The shapes are read
+// from the environment so regressions can be tracked on representative sizes
+// without rebuilding, ie:
+//
+//   SG_BENCH_TREES=4x10,6x8 ospray_sg_benchmark --benchmark_out=sg.json
+//     --benchmark_out_format=json
+
+namespace sg_bench {
+
+  using namespace ospray::sg;
+
+  // Applies the "<depth>x<width>,..." shapes of SG_BENCH_TREES (default
+  // "3x16,5x10") as benchmark arguments
+  inline void treeShapes(benchmark::internal::Benchmark *b)
+  {
+    const char *env = std::getenv("SG_BENCH_TREES");
+    std::string shapes = env ? env : "3x16,5x10";
+
+    size_t pos = 0;
+    while (pos < shapes.size()) {
+      auto end = shapes.find(',', pos);
+      if (end == std::string::npos)
+        end = shapes.size();
+
+      auto shape = shapes.substr(pos, end - pos);
+      auto x     = shape.find('x');
+      if (x != std::string::npos)
+        b->Args({std::stoll(shape.substr(0, x)),
+            std::stoll(shape.substr(x + 1))});
+      pos = end + 1;
+    }
+
+    b->ArgNames({"depth", "width"});
+  }
+
+  // Full tree of 'depth' levels below the root, each inner node having
+  // 'width' children.  Inner nodes are generic, the leaves parameters of a
+  // few common types.  Returns the root and collects the leaves.
+  inline NodePtr makeSyntheticTree(
+      int64_t depth, int64_t width, std::vector<NodePtr> *leaves = nullptr)
+  {
+    auto root = createNode("root");
+    std::vector<NodePtr> level{root};
+
+    for (int64_t d = 0; d < depth; d++) {
+      const bool isLeafLevel = d == depth - 1;
+
+      std::vector<NodePtr> next;
+      next.reserve(level.size() * width);
+
+      for (auto &parent : level) {
+        for (int64_t i = 0; i < width; i++) {
+          auto name = "node_" + std::to_string(i);
+          NodePtr child;
+          if (!isLeafLevel)
+            child = createNode(name);
+          else if (i % 3 == 0)
+            child = createNode(name, "float", float(i));
+          else if (i % 3 == 1)
+            child = createNode(name, "vec3f", vec3f(float(i)));
+          else
+            child = createNode(name, "bool", true);
+
+          parent->add(child);
+          next.push_back(child);
+        }
+      }
+
+      level.swap(next);
+    }
+
+    if (leaves)
+      *leaves = level;
+
+    return root;
+  }
+
+  // Changes the value of a leaf of makeSyntheticTree(), marking it modified
+  inline void touchLeaf(Node &leaf)
+  {
+    if (leaf.valueIsType<float>())
+      leaf.setValue(leaf.valueAs<float>() + 1.f);
+    else if (leaf.valueIsType<vec3f>())
+      leaf.setValue(leaf.valueAs<vec3f>() + 1.f);
+    else
+      leaf.setValue(!leaf.valueAs<bool>());
+  }
+
+  inline size_t treeSize(int64_t depth, int64_t width)
+  {
+    size_t size = 1, levelSize = 1;
+    for (int64_t d = 0; d < depth; d++)
+      size += (levelSize *= width);
+    return size;
+  }
+
+} // namespace sg_bench
@@ -0,0 +1,31 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include <benchmark/benchmark.h>
+
+#include "ospray/ospray.h"
+
+// Scene graph micro-benchmarks, built with -DUSE_BENCHMARK=ON.
+//
+// All of the Google Benchmark options apply, ie. to record a baseline and
+// compare a change against it:
+//
+//   ospray_sg_benchmark --benchmark_out=base.json --benchmark_out_format=json
+//   compare.py benchmarks base.json new.json
+//
+// The shapes of the synthetic trees are set with SG_BENCH_TREES (see
+// bench_common.h).
+
+int main(int argc, char *argv[])
+{
+  ospInit(nullptr, nullptr);
+
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  ::benchmark::RunSpecifiedBenchmarks();
+
+  ospShutdown();
+
+  return 0;
+}
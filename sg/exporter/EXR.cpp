@@ -9,6 +9,8 @@
 // openexr
 #include "OpenEXR/ImfChannelList.h"
 #include "OpenEXR/ImfOutputFile.h"
+// stl
+#include <memory>
 
 namespace ospray {
   namespace sg {
@@ -22,9 +24,17 @@ namespace ospray {
     template <typename T>
     T* flipBuffer(const void *buf, int ncomp = 4);
 
+    // Layers only, separate files would each need their own stream
+    bool beginStream() override;
+    bool writeRows(const void *rows, int numRows) override;
+    bool endStream() override;
+
    private:
     void doExportAsLayers();
     void doExportAsSeparateFiles();
+
+    std::unique_ptr<Imf::OutputFile> stream;
+    int nextRow{0};
   };
 
   OSP_REGISTER_SG_NODE_NAME(EXRExporter, exporter_exr);
@@ -278,6 +288,113 @@ namespace ospray {
       free(ptr.second);
   }
 
+  bool EXRExporter::beginStream()
+  {
+    if (child("layersAsSeparateFiles").valueAs<bool>())
+      return false;
+
+    auto file = FileName(child("file").valueAs<std::string>());
+    vec2i size = child("size").valueAs<vec2i>();
+
+    namespace IMF = OPENEXR_IMF_NAMESPACE;
+
+    Imf::Header exrHeader(size.x, size.y);
+    for (auto c : {"R", "G", "B", "A"})
+      exrHeader.channels().insert(c, Imf::Channel(IMF::FLOAT));
+    if (hasChild("albedo")) {
+      for (auto c : {"albedo.R", "albedo.G", "albedo.B"})
+        exrHeader.channels().insert(c, Imf::Channel(IMF::FLOAT));
+    }
+    if (hasChild("Z"))
+      exrHeader.channels().insert("Z", Imf::Channel(IMF::FLOAT));
+    if (hasChild("normal")) {
+      for (auto c : {"normal.X", "normal.Y", "normal.Z"})
+        exrHeader.channels().insert(c, Imf::Channel(IMF::FLOAT));
+    }
+
+    try {
+      stream.reset(new Imf::OutputFile(file.c_str(), exrHeader));
+    } catch (const std::exception &e) {
+      std::cerr << "Could not open " << file << ": " << e.what() << std::endl;
+      return false;
+    }
+
+    nextRow = 0;
+    return true;
+  }
+
+  bool EXRExporter::writeRows(const void *rows, int numRows)
+  {
+    vec2i size = child("size").valueAs<vec2i>();
+
+    namespace IMF = OPENEXR_IMF_NAMESPACE;
+
+    std::vector<float> converted;
+    const void *fb = rows;
+    if (child("format").valueAs<std::string>() != "float") {
+      converted.resize(4 * size_t(size.x) * numRows);
+      for (size_t i = 0; i < converted.size(); i++)
+        converted[i] = ((const uint8_t *)rows)[i] * ONEOVER255;
+      fb = converted.data();
+    }
+
+    // Slices address rows by their y in the whole image
+    auto makeSlice = [&](const void *band, int offset, int ncomp = 4) {
+      const size_t yStride = size.x * sizeof(float) * ncomp;
+      return Imf::Slice(IMF::FLOAT,
+          (char *)((float *)band + offset) - nextRow * yStride,
+          sizeof(float) * ncomp,
+          yStride);
+    };
+
+    Imf::FrameBuffer exrFb;
+    exrFb.insert("R", makeSlice(fb, 0));
+    exrFb.insert("G", makeSlice(fb, 1));
+    exrFb.insert("B", makeSlice(fb, 2));
+    exrFb.insert("A", makeSlice(fb, 3));
+
+    if (hasChild("albedo")) {
+      const void *albedo = child("albedo").valueAs<const void *>();
+      exrFb.insert("albedo.R", makeSlice(albedo, 0, 3));
+      exrFb.insert("albedo.G", makeSlice(albedo, 1, 3));
+      exrFb.insert("albedo.B", makeSlice(albedo, 2, 3));
+    }
+
+    if (hasChild("Z"))
+      exrFb.insert("Z", makeSlice(child("Z").valueAs<const void *>(), 0, 1));
+
+    if (hasChild("normal")) {
+      const void *normal = child("normal").valueAs<const void *>();
+      exrFb.insert("normal.X", makeSlice(normal, 0, 3));
+      exrFb.insert("normal.Y", makeSlice(normal, 1, 3));
+      exrFb.insert("normal.Z", makeSlice(normal, 2, 3));
+    }
+
+    try {
+      stream->setFrameBuffer(exrFb);
+      stream->writePixels(numRows);
+    } catch (const std::exception &e) {
+      std::cerr << "EXR error: " << e.what() << std::endl;
+      return false;
+    }
+
+    nextRow += numRows;
+    return true;
+  }
+
+  bool EXRExporter::endStream()
+  {
+    if (!stream)
+      return false;
+
+    // Completes the file
+    stream.reset();
+
+    std::cout << "EXR Saved to " << child("file").valueAs<std::string>()
+              << std::endl;
+    return true;
+  }
+
   template <typename T>
   T *EXRExporter::flipBuffer(const void *buf, int ncomp)
   {
@@ -0,0 +1,105 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ExportQueue.h"
+// stl
+#include <algorithm>
+#include <iostream>
+#include <memory>
+
+namespace ospray {
+  namespace sg {
+
+  ExportQueue::ExportQueue(size_t numThreads, size_t capacity)
+      : capacity(std::max<size_t>(capacity, 1))
+  {
+    for (size_t i = 0; i < std::max<size_t>(numThreads, 1); i++)
+      threads.emplace_back([this]() { work(); });
+  }
+
+  ExportQueue::~ExportQueue()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    notEmpty.notify_all();
+
+    for (auto &t : threads)
+      t.join();
+  }
+
+  void ExportQueue::push(Job job)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      notFull.wait(lock, [&]() { return jobs.size() < capacity; });
+      jobs.push_back(std::move(job));
+    }
+    notEmpty.notify_one();
+  }
+
+  void ExportQueue::flush()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return jobs.empty() && !running; });
+  }
+
+  void ExportQueue::work()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      notEmpty.wait(lock, [&]() { return stopping || !jobs.empty(); });
+      // remaining jobs are still run when stopping
+      if (jobs.empty())
+        return;
+
+      Job job = std::move(jobs.front());
+      jobs.pop_front();
+      running++;
+      lock.unlock();
+      notFull.notify_one();
+
+      try {
+        job();
+      } catch (const std::exception &e) {
+        std::cerr << "Export failed: " << e.what() << std::endl;
+      }
+      // release the job's data before the queue counts as flushed
+      job = nullptr;
+
+      lock.lock();
+      running--;
+      if (jobs.empty() && !running)
+        done.notify_all();
+    }
+  }
+
+  // Global export queue //////////////////////////////////////////////////////
+
+  ExportSettings exportSettings;
+
+  static std::unique_ptr<ExportQueue> globalQueue;
+  static std::mutex globalQueueMutex;
+
+  ExportQueue *exportQueue()
+  {
+    if (!exportSettings.numThreads)
+      return nullptr;
+
+    std::lock_guard<std::mutex> lock(globalQueueMutex);
+    if (!globalQueue)
+      globalQueue.reset(new ExportQueue(
+          exportSettings.numThreads, exportSettings.queueSize));
+    return globalQueue.get();
+  }
+
+  void flushExports()
+  {
+    std::lock_guard<std::mutex> lock(globalQueueMutex);
+    if (globalQueue)
+      globalQueue->flush();
+  }
+
+  }  // namespace sg
+} // namespace ospray
@@ -0,0 +1,71 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "../Node.h"
+// stl
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ospray {
+  namespace sg {
+
+  // Bounded queue of export jobs, run by worker threads.  push() blocks while
+  // the queue is full, so frames rendered faster than they are encoded hold
+  // back the renderer instead of piling up in memory.  Jobs must own the data
+  // they export, it is written after push() has returned.
+  struct OSPSG_INTERFACE ExportQueue
+  {
+    using Job = std::function<void()>;
+
+    ExportQueue(size_t numThreads, size_t capacity);
+    ~ExportQueue(); // runs the remaining jobs
+
+    void push(Job job);
+
+    // Waits until all queued jobs are done
+    void flush();
+
+   private:
+    void work();
+
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::condition_variable done;
+
+    std::deque<Job> jobs;
+    size_t capacity{0};
+    size_t running{0};
+    bool stopping{false};
+
+    std::vector<std::thread> threads;
+  };
+
+  // Global export settings ///////////////////////////////////////////////////
+
+  struct OSPSG_INTERFACE ExportSettings
+  {
+    // Threads encoding the images saved by FrameBuffer::saveFrame(), 0 saves
+    // them before returning
+    size_t numThreads{0};
+    // Frames which may wait for a thread before saveFrame() blocks
+    size_t queueSize{4};
+  };
+
+  extern OSPSG_INTERFACE ExportSettings exportSettings;
+
+  // Queue of FrameBuffer::saveFrame(), created from exportSettings on first
+  // use.  nullptr when saving synchronously.
+  OSPSG_INTERFACE ExportQueue *exportQueue();
+
+  // Waits until all frames saved so far are written
+  OSPSG_INTERFACE void flushExports();
+
+  }  // namespace sg
+} // namespace ospray
@@ -19,9 +19,28 @@ struct OSPSG_INTERFACE ImageExporter : public Exporter
   void setAdditionalLayer(std::string layerName, const void *fb);
   void clearLayer(std::string layerName);
 
+  // Streaming export, for images too large to hold in memory.  After
+  // setImageData() (with null data), the image is passed in bands of rows,
+  // from the top row down, already in file order.  Additional layers point
+  // to bands of the same rows.  Exporters which can't stream return false.
+  virtual bool beginStream()
+  {
+    return false;
+  }
+  virtual bool writeRows(const void * /*rows*/, int /*numRows*/)
+  {
+    return false;
+  }
+  virtual bool endStream()
+  {
+    return false;
+  }
+
  protected:
   void floatToChar();
   void charToFloat();
+
+  static vec4uc toChar(const vec4f &pixel);
 };
 
 // ImageExporter functions //////////////////////////////////////////////////
@@ -52,15 +71,8 @@ inline void ImageExporter::floatToChar()
   size_t npix = size.x * size.y;
   vec4uc *newfb = (vec4uc *)malloc(npix * sizeof(vec4uc));
   if (newfb) {
-    for (size_t i = 0; i < npix; i++) {
-      auto gamma = [](float x) -> float {
-        return pow(std::max(std::min(x, 1.f), 0.f), 1.f / 2.2f);
-      };
-      newfb[i].x = uint8_t(255 * gamma(fb[i].x));
-      newfb[i].y = uint8_t(255 * gamma(fb[i].y));
-      newfb[i].z = uint8_t(255 * gamma(fb[i].z));
-      newfb[i].w = uint8_t(255 * std::max(std::min(fb[i].w, 1.f), 0.f));
-    }
+    for (size_t i = 0; i < npix; i++)
+      newfb[i] = toChar(fb[i]);
 
     child("data") = (const void *)newfb;
   }
@@ -76,6 +88,17 @@ inline void ImageExporter::floatToChar()
   }
 }
 
+inline vec4uc ImageExporter::toChar(const vec4f &pixel)
+{
+  auto gamma = [](float x) -> float {
+    return pow(std::max(std::min(x, 1.f), 0.f), 1.f / 2.2f);
+  };
+  return vec4uc(uint8_t(255 * gamma(pixel.x)),
+      uint8_t(255 * gamma(pixel.y)),
+      uint8_t(255 * gamma(pixel.z)),
+      uint8_t(255 * std::max(std::min(pixel.w, 1.f), 0.f)));
+}
+
 inline void ImageExporter::charToFloat()
 {
   const uint8_t *fb = (const uint8_t *)child("data").valueAs<const void *>();
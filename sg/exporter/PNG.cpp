@@ -6,20 +6,78 @@
 #include "rkcommon/os/FileName.h"
 // stb
 #include "stb_image_write.h"
+// stl
+#include <array>
+#include <cstring>
+#include <fstream>
+#if defined(USE_ZLIB)
+#include <zlib.h>
+#endif
 
 namespace ospray {
   namespace sg {
 
   struct PNGExporter : public ImageExporter
   {
-    PNGExporter()  = default;
-    ~PNGExporter() = default;
+    PNGExporter() = default;
+    ~PNGExporter() override;
 
     void doExport() override;
+
+    // Bands of rows are deflated into one zlib stream spread over IDAT
+    // chunks, with zlib if available, otherwise as stored (uncompressed)
+    // blocks
+    bool beginStream() override;
+    bool writeRows(const void *rows, int numRows) override;
+    bool endStream() override;
+
+   private:
+    bool deflateBand(const uint8_t *data, size_t size, bool finish);
+    void writeChunk(const char *tag, const uint8_t *data, size_t size);
+
+    std::ofstream out;
+    std::vector<uint8_t> previousRow; // for the "up" filter
+    std::vector<uint8_t> idat; // deflated bytes of the next IDAT chunk
+#if defined(USE_ZLIB)
+    z_stream zstream;
+    bool zstreamOpen{false};
+#else
+    uint32_t adlerA{1};
+    uint32_t adlerB{0};
+#endif
   };
 
   OSP_REGISTER_SG_NODE_NAME(PNGExporter, exporter_png);
 
+  // Helper functions /////////////////////////////////////////////////////////
+
+  static uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+  {
+    static const auto table = []() {
+      std::array<uint32_t, 256> t;
+      for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+          c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        t[i] = c;
+      }
+      return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+      crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+  }
+
+  static void putBigEndian(uint8_t *dst, uint32_t value)
+  {
+    dst[0] = uint8_t(value >> 24);
+    dst[1] = uint8_t(value >> 16);
+    dst[2] = uint8_t(value >> 8);
+    dst[3] = uint8_t(value);
+  }
+
   // PNGExporter definitions //////////////////////////////////////////////////
 
   void PNGExporter::doExport()
@@ -50,5 +108,198 @@ namespace ospray {
       std::cout << "Saved to " << file << std::endl;
   }
 
+  bool PNGExporter::beginStream()
+  {
+    auto file = FileName(child("file").valueAs<std::string>());
+    vec2i size = child("size").valueAs<vec2i>();
+
+    out.open(file.c_str(), std::ios::binary);
+    if (!out) {
+      std::cerr << "Could not open " << file << std::endl;
+      return false;
+    }
+
+    static const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    out.write((const char *)signature, sizeof(signature));
+
+    // 8 bits per channel RGBA, no interlacing
+    uint8_t header[13] = {0};
+    putBigEndian(header, size.x);
+    putBigEndian(header + 4, size.y);
+    header[8] = 8;
+    header[9] = 6;
+    writeChunk("IHDR", header, sizeof(header));
+
+    previousRow.assign(4 * size_t(size.x), 0);
+    idat.clear();
+
+#if defined(USE_ZLIB)
+    if (zstreamOpen)
+      deflateEnd(&zstream);
+    zstream = z_stream();
+    const int level = std::max(0, std::min(stbi_write_png_compression_level, 9));
+    zstreamOpen = deflateInit(&zstream, level) == Z_OK;
+    if (!zstreamOpen)
+      return false;
+#else
+    idat = {0x78, 0x01}; // zlib header
+    adlerA = 1;
+    adlerB = 0;
+#endif
+
+    return bool(out);
+  }
+
+  bool PNGExporter::writeRows(const void *rows, int numRows)
+  {
+    const vec2i size = child("size").valueAs<vec2i>();
+    const bool isFloat = child("format").valueAs<std::string>() == "float";
+    const size_t rowBytes = 4 * size_t(size.x);
+
+    // Each row is the filter type, then the differences to the row above
+    std::vector<uint8_t> filtered((rowBytes + 1) * numRows);
+    uint8_t *dst = filtered.data();
+    std::vector<uint8_t> row(rowBytes);
+    for (int y = 0; y < numRows; y++) {
+      if (isFloat) {
+        auto *src = (const vec4f *)rows + size_t(y) * size.x;
+        for (int x = 0; x < size.x; x++)
+          ((vec4uc *)row.data())[x] = toChar(src[x]);
+      } else {
+        std::memcpy(row.data(), (const uint8_t *)rows + y * rowBytes, rowBytes);
+      }
+
+      *dst++ = 2; // up
+      for (size_t i = 0; i < rowBytes; i++)
+        *dst++ = uint8_t(row[i] - previousRow[i]);
+      previousRow.swap(row);
+    }
+
+    return deflateBand(filtered.data(), filtered.size(), false) && bool(out);
+  }
+
+  bool PNGExporter::endStream()
+  {
+    const bool finished = deflateBand(nullptr, 0, true);
+#if defined(USE_ZLIB)
+    deflateEnd(&zstream);
+    zstreamOpen = false;
+#endif
+
+    writeChunk("IEND", nullptr, 0);
+    out.close();
+
+    if (!finished || !out) {
+      std::cerr << "Could not save " << child("file").valueAs<std::string>()
+                << std::endl;
+      return false;
+    }
+
+    std::cout << "Saved to " << child("file").valueAs<std::string>()
+              << std::endl;
+    return true;
+  }
+
+  PNGExporter::~PNGExporter()
+  {
+#if defined(USE_ZLIB)
+    if (zstreamOpen)
+      deflateEnd(&zstream);
+#endif
+  }
+
+  // Appends the band to the zlib stream, 'finish' ends it.  Whatever is
+  // deflated so far goes out as IDAT chunks.
+  bool PNGExporter::deflateBand(const uint8_t *data, size_t size, bool finish)
+  {
+#if defined(USE_ZLIB)
+    static const size_t chunkSize = 1 << 20;
+
+    if (!zstreamOpen)
+      return false;
+
+    // zlib counts input in 32 bits
+    do {
+      const size_t n = std::min<size_t>(size, 1u << 30);
+      zstream.next_in = const_cast<Bytef *>(data);
+      zstream.avail_in = uInt(n);
+      data += n;
+      size -= n;
+      const int flush = finish && !size ? Z_FINISH : Z_NO_FLUSH;
+
+      int res = Z_OK;
+      do {
+        const size_t used = idat.size();
+        idat.resize(chunkSize);
+        zstream.next_out = idat.data() + used;
+        zstream.avail_out = uInt(chunkSize - used);
+        res = deflate(&zstream, flush);
+        idat.resize(chunkSize - zstream.avail_out);
+        if (res == Z_STREAM_ERROR)
+          return false;
+
+        if (idat.size() == chunkSize) {
+          writeChunk("IDAT", idat.data(), idat.size());
+          idat.clear();
+        }
+      } while (flush == Z_FINISH ? res != Z_STREAM_END : zstream.avail_in > 0);
+    } while (size);
+#else
+    for (size_t i = 0; i < size;) {
+      const uint16_t len = uint16_t(std::min<size_t>(size - i, 65535));
+      const uint8_t header[5] = {0, // not final, stored
+          uint8_t(len),
+          uint8_t(len >> 8),
+          uint8_t(~len),
+          uint8_t(~len >> 8)};
+      idat.insert(idat.end(), header, header + 5);
+      idat.insert(idat.end(), data + i, data + i + len);
+      i += len;
+    }
+
+    for (size_t i = 0; i < size;) {
+      // largest run without overflowing the sums
+      const size_t end = std::min(size, i + 5552);
+      for (; i < end; i++) {
+        adlerA += data[i];
+        adlerB += adlerA;
+      }
+      adlerA %= 65521;
+      adlerB %= 65521;
+    }
+
+    if (finish) {
+      static const uint8_t last[5] = {1, 0, 0, 0xFF, 0xFF}; // empty, final
+      idat.insert(idat.end(), last, last + 5);
+
+      uint8_t adler[4];
+      putBigEndian(adler, adlerB << 16 | adlerA);
+      idat.insert(idat.end(), adler, adler + 4);
+    }
+#endif
+
+    if (!idat.empty()) {
+      writeChunk("IDAT", idat.data(), idat.size());
+      idat.clear();
+    }
+
+    return true;
+  }
+
+  void PNGExporter::writeChunk(
+      const char *tag, const uint8_t *data, size_t size)
+  {
+    uint8_t length[4];
+    putBigEndian(length, uint32_t(size));
+    out.write((const char *)length, 4);
+    out.write(tag, 4);
+    if (size)
+      out.write((const char *)data, size);
+
+    uint8_t crc[4];
+    putBigEndian(crc, crc32(data, size, crc32((const uint8_t *)tag, 4)));
+    out.write((const char *)crc, 4);
+  }
+
   }  // namespace sg
 } // namespace ospray
@@ -5,6 +5,8 @@
 // rkcommon
 #include "rkcommon/os/FileName.h"
 #include "rkcommon/utility/SaveImage.h"
+// stl
+#include <fstream>
 
 namespace ospray {
   namespace sg {
@@ -15,6 +17,17 @@ namespace ospray {
     ~PPMExporter() = default;
 
     void doExport() override;
+
+    // PPM rows are written in order, PFM rows (stored bottom up) at their
+    // offset in the file
+    bool beginStream() override;
+    bool writeRows(const void *rows, int numRows) override;
+    bool endStream() override;
+
+   private:
+    std::fstream out;
+    std::streamoff dataStart{0};
+    int nextRow{0};
   };
 
   OSP_REGISTER_SG_NODE_NAME(PPMExporter, exporter_ppm);
@@ -56,6 +69,78 @@ namespace ospray {
     std::cout << "Saved to " << file << std::endl;
   }
 
+  bool PPMExporter::beginStream()
+  {
+    auto fn = child("file").valueAs<std::string>();
+    const bool isFloat = child("format").valueAs<std::string>() == "float";
+    vec2i size = child("size").valueAs<vec2i>();
+
+    // Same naming as doExport()
+    if (isFloat) {
+      auto dot = fn.find_last_of('.');
+      fn = dot == std::string::npos ? fn + ".pfm" : fn.substr(0, dot + 1) + "pfm";
+      child("file") = fn;
+    }
+
+    out.open(fn.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out) {
+      std::cerr << "Could not open " << fn << std::endl;
+      return false;
+    }
+
+    out << (isFloat ? "PF\n" : "P6\n") << size.x << " " << size.y
+        << (isFloat ? "\n-1.0\n" : "\n255\n");
+    dataStart = out.tellp();
+    nextRow = 0;
+
+    return bool(out);
+  }
+
+  bool PPMExporter::writeRows(const void *rows, int numRows)
+  {
+    const bool isFloat = child("format").valueAs<std::string>() == "float";
+    vec2i size = child("size").valueAs<vec2i>();
+
+    if (!isFloat) {
+      std::vector<vec3uc> rgb(size.x);
+      for (int y = 0; y < numRows; y++) {
+        auto *src = (const vec4uc *)rows + size_t(y) * size.x;
+        for (int x = 0; x < size.x; x++)
+          rgb[x] = vec3uc(src[x].x, src[x].y, src[x].z);
+        out.write((const char *)rgb.data(), rgb.size() * sizeof(vec3uc));
+      }
+    } else {
+      std::vector<vec3f> rgb(size.x);
+      const std::streamoff rowBytes = size.x * sizeof(vec3f);
+      for (int y = 0; y < numRows; y++) {
+        auto *src = (const vec4f *)rows + size_t(y) * size.x;
+        for (int x = 0; x < size.x; x++)
+          rgb[x] = vec3f(src[x].x, src[x].y, src[x].z);
+        out.seekp(dataStart + (size.y - 1 - nextRow - y) * rowBytes);
+        out.write((const char *)rgb.data(), rowBytes);
+      }
+    }
+
+    nextRow += numRows;
+    return bool(out);
+  }
+
+  bool PPMExporter::endStream()
+  {
+    out.seekp(0, std::ios::end);
+    out << "\n";
+    out.close();
+
+    auto file = child("file").valueAs<std::string>();
+    if (!out) {
+      std::cerr << "Could not save " << file << std::endl;
+      return false;
+    }
+
+    std::cout << "Saved to " << file << std::endl;
+    return true;
+  }
+
   }  // namespace sg
 } // namespace ospray
 
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "FrameBuffer.h"
+#include "../exporter/ExportQueue.h"
 #include "../exporter/ImageExporter.h"
 
 #include "sg/camera/Camera.h"
@@ -9,6 +10,9 @@
 #include "sg/scene/World.h"
 
 #include "sg/Mpi.h"
+// stl
+#include <memory>
+#include <set>
 
 namespace ospray {
 namespace sg {
@@ -62,12 +66,27 @@ NodeType FrameBuffer::type() const
 
 const void *FrameBuffer::map(OSPFrameBufferChannel channel)
 {
-  return handle().map(channel);
+  auto fb = frontIsSpare ? spare : handle();
+  const void *mem = fb.map(channel);
+  mappings.emplace_back(mem, fb);
+  return mem;
 }
 
 void FrameBuffer::unmap(const void *mem)
 {
-  handle().unmap(const_cast<void *>(mem));
+  auto m = std::find_if(mappings.begin(),
+      mappings.end(),
+      [&](const std::pair<const void *, cpp::FrameBuffer> &m) {
+        return m.first == mem;
+      });
+
+  if (m == mappings.end()) {
+    handle().unmap(const_cast<void *>(mem));
+    return;
+  }
+
+  m->second.unmap(const_cast<void *>(mem));
+  mappings.erase(m);
 }
 
 void FrameBuffer::resetAccumulation()
@@ -80,9 +99,53 @@ float FrameBuffer::variance()
   return handle().variance();
 }
 
+FrameBuffer::Change FrameBuffer::pendingChange()
+{
+  static const std::set<std::string> bufferParams = {
+      "floatFormat", "size", "colorFormat", "sRGB"};
+  static const std::set<std::string> imageOpParams = {"exposure",
+      "contrast",
+      "shoulder",
+      "midIn",
+      "midOut",
+      "hdrMax",
+      "acesColor"};
+
+  // The node itself is modified by adding or removing children
+  if (lastModified() > lastCommitted())
+    return Change::BUFFER;
+
+  auto change = Change::NONE;
+  for (auto *c : modifiedChildren()) {
+    if (bufferParams.count(c->name()))
+      return Change::BUFFER;
+    if (imageOpParams.count(c->name()))
+      change = Change::IMAGE_OPS;
+  }
+
+  return change;
+}
+
+void FrameBuffer::preCommit()
+{
+  // Children are committed, and forgotten as modified, before postCommit()
+  committing = pendingChange();
+  OSPNode::preCommit();
+}
+
 void FrameBuffer::postCommit()
 {
-  updateHandle();
+  switch (committing) {
+  case Change::BUFFER:
+    updateHandle();
+    break;
+  case Change::IMAGE_OPS:
+    updateImageOps = true;
+    updateImageOperations();
+    break;
+  case Change::NONE:
+    break;
+  }
 }
 
 void FrameBuffer::updateHandle()
@@ -104,23 +167,77 @@ void FrameBuffer::updateHandle()
     child("colorFormat") = std::string(sRGB ? "sRGB" : "RGBA8");
   }
 
+  // The parameters derived above come back as modified on the next commit,
+  // which doesn't need a new buffer
+  auto size = child("size").valueAs<vec2i>();
+  auto colorFormat = child("colorFormat").valueAs<std::string>();
+  if (size == allocatedSize && colorFormat == allocatedFormat
+      && channels == allocatedChannels)
+    return;
+
+  allocatedSize = size;
+  allocatedFormat = colorFormat;
+  allocatedChannels = channels;
+
+  setHandle(createBuffer());
+  if (pipelined)
+    spare = createBuffer();
+  frontIsSpare = false;
+
+  // Recreating the framebuffer will change the imageOps.  Refresh them.
+  if (hasDenoiser || hasToneMapper) {
+    updateImageOps = true;
+    updateImageOperations();
+  }
+}
+
+cpp::FrameBuffer FrameBuffer::createBuffer()
+{
   auto size = child("size").valueAs<vec2i>();
   // Assure that neither dimension is 0.
   size = vec2i(std::max(size.x, 1), std::max(size.y, 1));
   auto colorFormatStr = child("colorFormat").valueAs<std::string>();
 
-  auto fb =
-      cpp::FrameBuffer(size.x, size.y, colorFormats[colorFormatStr], channels);
+  return cpp::FrameBuffer(
+      size.x, size.y, colorFormats[colorFormatStr], channels);
+}
+
+void FrameBuffer::setPipelined(bool enabled)
+{
+  if (enabled == pipelined)
+    return;
 
-  setHandle(fb);
+  pipelined = enabled;
+  frontIsSpare = false;
+  if (!pipelined) {
+    spare = cpp::FrameBuffer();
+    return;
+  }
 
-  // Recreating the framebuffer will change the imageOps.  Refresh them.
+  spare = createBuffer();
   if (hasDenoiser || hasToneMapper) {
     updateImageOps = true;
     updateImageOperations();
   }
 }
 
+void FrameBuffer::swapBuffers()
+{
+  if (!pipelined)
+    return;
+
+  // Not a modification, the settings of both buffers are the same
+  auto rendered = handle();
+  setHandle(spare, false);
+  spare = rendered;
+  frontIsSpare = true;
+}
+
+void FrameBuffer::presentRendered()
+{
+  frontIsSpare = false;
+}
+
 void FrameBuffer::updateDenoiser(bool enabled)
 {
   // Denoiser requires float color buffer.
@@ -175,11 +292,17 @@ void FrameBuffer::updateImageOperations()
   if (hasDenoiser)
     ops.push_back(cpp::ImageOperation("denoiser"));
 
-  if (isFloatFormat() && (hasDenoiser || hasToneMapper))
-    handle().setParam("imageOperation", cpp::CopiedData(ops));
-  else
-    handle().removeParam("imageOperation");
-  handle().commit();
+  auto setOps = [&](const cpp::FrameBuffer &fb) {
+    if (isFloatFormat() && (hasDenoiser || hasToneMapper))
+      fb.setParam("imageOperation", cpp::CopiedData(ops));
+    else
+      fb.removeParam("imageOperation");
+    fb.commit();
+  };
+
+  setOps(handle());
+  if (pipelined)
+    setOps(spare);
 }
 
 void FrameBuffer::saveFrame(std::string filename, int flags)
@@ -196,65 +319,70 @@ void FrameBuffer::saveFrame(std::string filename, int flags)
   }
   filenames.push_back(filename);
 
+  auto size = child("size").valueAs<vec2i>();
+  auto fmt = child("colorFormat").valueAs<std::string>();
+  const size_t numPixels = size_t(size.x) * size.y;
+
+  bool albedo = flags & 0b1;
+  bool depth = flags & 0b10;
+  bool normal = flags & 0b100;
+  bool layersAsSeparateFiles = flags & 0b1000;
+
+  // Queued exports are written later, from copies of the channels taken
+  // now, so the framebuffer is unmapped (and may render again) right away
+  auto *queue = exportQueue();
+  auto copies = std::make_shared<std::vector<std::vector<uint8_t>>>();
+  std::vector<const void *> mapped;
+
+  auto mapChannel = [&](OSPFrameBufferChannel channel, size_t pixelBytes) {
+    const void *mem = map(channel);
+    if (!queue) {
+      mapped.push_back(mem);
+      return mem;
+    }
+    const uint8_t *bytes = (const uint8_t *)mem;
+    copies->emplace_back(bytes, bytes + numPixels * pixelBytes);
+    unmap(mem);
+    return (const void *)copies->back().data();
+  };
+
+  const void *fb =
+      mapChannel(OSP_FB_COLOR, fmt == "float" ? sizeof(vec4f) : sizeof(vec4uc));
+  const void *abuf = albedo ? mapChannel(OSP_FB_ALBEDO, sizeof(vec3f)) : nullptr;
+  const void *zbuf = depth ? mapChannel(OSP_FB_DEPTH, sizeof(float)) : nullptr;
+  const void *nbuf = normal ? mapChannel(OSP_FB_NORMAL, sizeof(vec3f)) : nullptr;
+
   for (auto &f : filenames) {
     auto exporter = getExporter(FileName(f));
 
     if (exporter == "") {
       std::cout << "No exporter found for type " << FileName(filename).ext()
                 << std::endl;
-      return;
+      break;
     }
     auto exp = createNodeAs<ImageExporter>("exporter", exporter);
     exp->child("file") = f;
 
-    auto fb = map(OSP_FB_COLOR);
-    auto size = child("size").valueAs<vec2i>();
-    auto fmt = child("colorFormat").valueAs<std::string>();
-    void *abuf = nullptr;
-    void *zbuf = nullptr;
-    void *nbuf = nullptr;
-
     exp->setImageData(fb, size, fmt);
 
-    bool albedo = flags & 0b1;
-    bool depth = flags & 0b10;
-    bool normal = flags & 0b100;
-    bool layersAsSeparateFiles = flags & 0b1000;
-
-    if (albedo) {
-      abuf = (void *)map(OSP_FB_ALBEDO);
+    if (abuf)
       exp->setAdditionalLayer("albedo", abuf);
-    } else {
-      exp->clearLayer("albedo");
-    }
-
-    if (depth) {
-      zbuf = (void *)map(OSP_FB_DEPTH);
+    if (zbuf)
       exp->setAdditionalLayer("Z", zbuf);
-    } else {
-      exp->clearLayer("Z");
-    }
-
-    if (normal) {
-      nbuf = (void *)map(OSP_FB_NORMAL);
+    if (nbuf)
       exp->setAdditionalLayer("normal", nbuf);
-    } else {
-      exp->clearLayer("normal");
-    }
 
     exp->createChild("layersAsSeparateFiles", "bool", layersAsSeparateFiles);
     exp->createChild("saveColor", "bool", file.ext() == "exr");
 
-    exp->doExport();
-
-    unmap(fb);
-    if (abuf)
-      unmap(abuf);
-    if (zbuf)
-      unmap(zbuf);
-    if (nbuf)
-      unmap(nbuf);
+    if (queue)
+      queue->push([exp, copies]() { exp->doExport(); });
+    else
+      exp->doExport();
   }
+
+  for (auto *mem : mapped)
+    unmap(mem);
 }
 
 OSP_REGISTER_SG_NODE_NAME(FrameBuffer, framebuffer);
@@ -15,6 +15,15 @@ namespace ospray {
 
     NodeType type() const override;
 
+    // What the parameters modified since the last commit require
+    enum class Change
+    {
+      NONE, // nothing, ie. parameters only known to the application
+      IMAGE_OPS, // new image operations, the accumulation stays valid
+      BUFFER // a new framebuffer (size, format)
+    };
+    Change pendingChange();
+
     const void *map(OSPFrameBufferChannel = OSP_FB_COLOR);
     void unmap(const void *mem);
     float variance();
@@ -25,6 +34,19 @@ namespace ospray {
     void updateImageOperations();
     void saveFrame(std::string filename, int flags);
 
+    // Pipelined rendering (see Frame::pipelined) keeps a second OSPRay
+    // framebuffer with the same settings.  The handle is always the one
+    // rendered into, map() reads the last completed frame: swapBuffers()
+    // moves it to the spare, where it stays until presentRendered().
+    void setPipelined(bool enabled);
+    void swapBuffers();
+    void presentRendered();
+
+    inline bool completedInSpare() const
+    {
+      return frontIsSpare;
+    }
+
     inline bool isFloatFormat()
     {
       return (child("colorFormat").valueAs<std::string>() == "float");
@@ -45,12 +67,30 @@ namespace ospray {
       return (channels & OSP_FB_ALBEDO);
     }
 
+    inline bool hasNormalChannel()
+    {
+      return (channels & OSP_FB_NORMAL);
+    }
+
    private:
+    void preCommit() override;
     void postCommit() override;
 
     void updateHandle();
+    cpp::FrameBuffer createBuffer();
     uint32_t channels{OSP_FB_COLOR};  // OSPFrameBufferChannel
 
+    Change committing{Change::NONE};
+    vec2i allocatedSize{0};
+    std::string allocatedFormat;
+    uint32_t allocatedChannels{0};
+
+    bool pipelined{false};
+    bool frontIsSpare{false};
+    cpp::FrameBuffer spare;
+    // Unmapped from the buffer they were mapped from, which may have swapped
+    std::vector<std::pair<const void *, cpp::FrameBuffer>> mappings;
+
     bool hasDenoiser{false};
     bool hasToneMapper{false};
     bool updateImageOps{false};
@@ -0,0 +1,105 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "sg/Data.h"
+#include "sg/scene/geometry/Geometry.h"
+#include "sg/scene/transfer_function/TransferFunction.h"
+#include "sg/scene/volume/Volume.h"
+// stl
+#include <string>
+#include <vector>
+
+namespace ospray {
+namespace sg {
+
+// Host array backing a data parameter
+struct HostArray
+{
+  std::string param;
+  const void *data{nullptr};
+  size_t numItems{0};
+  size_t numBytes{0};
+  size_t byteStride{0}; // between items, 0 if they are packed
+};
+
+template <typename T>
+inline HostArray hostArray(const std::string &param, const std::vector<T> &v)
+{
+  return {param, v.data(), v.size(), v.size() * sizeof(T)};
+}
+
+// Importers keep the arrays of their geometries in the Geometry node, shared
+// with OSPRay.  Returns an empty array for parameters backed by anything else
+// (ie. data shared directly from imported buffers, see Data::sharedMemory).
+inline HostArray hostArrayOf(const Geometry &geom, const std::string &param)
+{
+  if (param == "vertex.position" || param == "sphere.position")
+    return hostArray(param,
+        geom.skinnedPositions.empty() ? geom.positions : geom.skinnedPositions);
+  if (param == "vertex.normal")
+    return hostArray(param,
+        geom.skinnedNormals.empty() ? geom.normals : geom.skinnedNormals);
+  if (param == "vertex.color" || param == "color")
+    return hostArray(param, geom.vc);
+  if (param == "vertex.texcoord" || param == "sphere.texcoord")
+    return hostArray(param, geom.vt);
+  if (param == "index")
+    return geom.vi.empty() ? hostArray(param, geom.quad_vi)
+                           : hostArray(param, geom.vi);
+  if (param == "material")
+    return hostArray(param, geom.mIDs);
+  return {};
+}
+
+// The memory shared by 'data', empty for copied data or items strided in
+// more than one dimension
+inline HostArray sharedArrayOf(const Data &data)
+{
+  if (!data.sharedMemory
+      || !(data.isDense() || data.numItems.y * data.numItems.z == 1))
+    return {};
+  return {data.name(),
+      data.sharedMemory,
+      data.numItems.long_product(),
+      data.numItems.long_product() * data.itemBytes,
+      data.isDense() ? 0 : data.byteStride.x};
+}
+
+// The items of data parameter 'data' of 'geom', from its host array or the
+// memory it shares.  Empty if they're only held by OSPRay (ie. copied data),
+// or don't match the parameter.
+inline HostArray dataArrayOf(const Geometry &geom, const Data &data)
+{
+  auto array = hostArrayOf(geom, data.name());
+  if (!array.data)
+    array = sharedArrayOf(data);
+  if (array.numItems != data.numItems.long_product())
+    return {};
+  return array;
+}
+
+// Volumes share their voxels, see Volume::voxels
+inline HostArray dataArrayOf(const Volume &volume, const Data &data)
+{
+  if (!volume.voxels || data.sharedMemory != volume.voxels.get())
+    return {};
+  return sharedArrayOf(data);
+}
+
+// Transfer functions copy their colors and opacities to OSPRay, but keep them
+inline HostArray dataArrayOf(const TransferFunction &tf, const Data &data)
+{
+  HostArray array;
+  if (data.name() == "color")
+    array = hostArray(data.name(), tf.colors);
+  else if (data.name() == "opacity")
+    array = hostArray(data.name(), tf.opacities);
+  if (array.numItems != data.numItems.long_product())
+    return {};
+  return array;
+}
+
+} // namespace sg
+} // namespace ospray
@@ -2,9 +2,16 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "Importer.h"
+#include "HostArray.h"
 #include "sg/visitors/PrintNodes.h"
+#include "sg/scene/geometry/Geometry.h"
 
 #include "../JSONDefs.h"
+// stl
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ospray {
 namespace sg {
@@ -30,6 +37,290 @@ NodeType Importer::type() const
 void Importer::importScene() {
 }
 
+// Scene cache ////////////////////////////////////////////////////////////////
+
+bool Importer::startSceneCache()
+{
+  if (cacheFile.empty())
+    return false;
+
+  auto fnd = importerMap.find(rkcommon::utility::lowerCase(fileName.ext()));
+  if (materialRegistry && fnd != importerMap.end()) {
+    const auto key = sceneCacheKey(fnd->second);
+    if (sceneCacheIsCurrent(cacheFile, key.source, key.importer)) {
+      auto rootNode = readSceneCache(cacheFile, key, *materialRegistry);
+      if (rootNode) {
+        add(rootNode);
+        std::cout << "Imported " << fileName << " from " << cacheFile
+                  << std::endl;
+        return true;
+      }
+    }
+  }
+
+  cacheStart.firstMaterial =
+      materialRegistry ? materialRegistry->baseMaterialOffSet() : 0;
+  cacheStart.numAnimations = animations ? animations->size() : 0;
+  cacheStart.numCameras = cameras ? cameras->size() : 0;
+  cacheStart.numLights = lightsManager ? lightsManager->children().size() : 0;
+  return false;
+}
+
+void Importer::finishSceneCache(const Node &rootNode)
+{
+  if (cacheFile.empty() || !materialRegistry)
+    return;
+
+  if ((animations ? animations->size() : 0) != cacheStart.numAnimations
+      || (cameras ? cameras->size() : 0) != cacheStart.numCameras
+      || (lightsManager ? lightsManager->children().size() : 0)
+          != cacheStart.numLights) {
+    std::cout << "Not caching " << fileName
+              << ", it has cameras, lights or animations" << std::endl;
+    return;
+  }
+
+  auto fnd = importerMap.find(rkcommon::utility::lowerCase(fileName.ext()));
+  if (fnd != importerMap.end())
+    writeSceneCache(cacheFile,
+        sceneCacheKey(fnd->second),
+        rootNode,
+        *materialRegistry,
+        cacheStart.firstMaterial);
+}
+
+SceneCacheKey Importer::sceneCacheKey(const std::string &importer) const
+{
+  // Settings which change what the importers create, including the
+  // parameters of raw volumes
+  std::ostringstream settings;
+  settings << "pointSize " << pointSize << " cameras " << importCameras
+           << " deduplicate " << deduplicateGeometry << " instances " << ic;
+  if (volumeParams && volumeParams->hasChild("dimensions")) {
+    auto &params = *volumeParams;
+    settings << " voxelType " << params["voxelType"].valueAs<int>()
+             << " dimensions " << params["dimensions"].valueAs<vec3i>()
+             << " gridOrigin " << params["gridOrigin"].valueAs<vec3f>()
+             << " gridSpacing " << params["gridSpacing"].valueAs<vec3f>();
+  }
+
+  auto source = fileName;
+  SceneCacheKey key;
+  key.source = source.canonical();
+  key.importer = importer;
+  key.settings = settings.str();
+  return key;
+}
+
+// Geometry deduplication /////////////////////////////////////////////////////
+
+namespace {
+
+inline uint64_t hashBytes(const void *data, size_t numBytes, uint64_t h)
+{
+  const uint64_t k = 0x9e3779b97f4a7c15ull;
+  auto *bytes = static_cast<const uint8_t *>(data);
+
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= numBytes; i += sizeof(uint64_t)) {
+    uint64_t w;
+    std::memcpy(&w, bytes + i, sizeof(w));
+    h = (h ^ (w * k)) * 0xff51afd7ed558ccdull;
+    h ^= h >> 32;
+  }
+  for (; i < numBytes; i++)
+    h = (h ^ bytes[i]) * 0x100000001b3ull;
+
+  return h ^ numBytes;
+}
+
+inline uint64_t hashArray(const HostArray &a, uint64_t h)
+{
+  if (!a.byteStride || !a.numItems)
+    return hashBytes(a.data, a.numBytes, h);
+
+  auto *bytes = static_cast<const uint8_t *>(a.data);
+  const size_t itemBytes = a.numBytes / a.numItems;
+  for (size_t i = 0; i < a.numItems; i++)
+    h = hashBytes(bytes + i * a.byteStride, itemBytes, h);
+  return h;
+}
+
+// Same number of bytes assumed
+inline bool sameBytes(const HostArray &a, const HostArray &b)
+{
+  if ((!a.byteStride && !b.byteStride) || !a.numItems)
+    return !std::memcmp(a.data, b.data, a.numBytes);
+
+  auto *x = static_cast<const uint8_t *>(a.data);
+  auto *y = static_cast<const uint8_t *>(b.data);
+  const size_t itemBytes = a.numBytes / a.numItems;
+  const size_t xStride = a.byteStride ? a.byteStride : itemBytes;
+  const size_t yStride = b.byteStride ? b.byteStride : itemBytes;
+  for (size_t i = 0; i < a.numItems; i++)
+    if (std::memcmp(x + i * xStride, y + i * yStride, itemBytes))
+      return false;
+  return true;
+}
+
+// What makes two geometries identical: their data arrays and the values of
+// their other parameters
+struct GeometryContent
+{
+  NodePtr node;
+  std::vector<HostArray> arrays;
+  std::vector<const Node *> values;
+  size_t numBytes{0};
+  size_t numPrimitives{0};
+  uint64_t hash{0};
+};
+
+bool describeGeometry(NodePtr node, GeometryContent &content)
+{
+  auto &geom = *node->nodeAs<Geometry>();
+
+  // skinned geometries are modified every frame, each by its own skin
+  if (geom.skin || geom.weightsPerVertex)
+    return false;
+
+  content.node = node;
+  for (auto &c : geom.children()) {
+    auto &param = *c.second;
+    if (!param.children().empty())
+      return false;
+
+    auto *data = dynamic_cast<const Data *>(&param);
+    if (!data) {
+      content.values.push_back(&param);
+      continue;
+    }
+
+    auto array = dataArrayOf(geom, *data);
+    if (!array.data)
+      return false;
+
+    if (array.param == "index"
+        || (array.param == "sphere.position" && !geom.hasChild("index")))
+      content.numPrimitives = array.numItems;
+    content.numBytes += array.numBytes;
+    content.arrays.push_back(array);
+  }
+
+  return true;
+}
+
+// Cheap hash of the layout only, to skip hashing geometries of unique shape
+uint64_t shapeHash(const GeometryContent &content)
+{
+  auto h = std::hash<std::string>()(content.node->subType());
+  for (auto &a : content.arrays)
+    h = hashBytes(&a.numBytes, sizeof(a.numBytes),
+        h ^ std::hash<std::string>()(a.param));
+  for (auto *v : content.values)
+    h ^= std::hash<std::string>()(v->name()) + (h << 6) + (h >> 2);
+  return h;
+}
+
+bool sameContent(const GeometryContent &a, const GeometryContent &b)
+{
+  if (a.node->subType() != b.node->subType()
+      || a.arrays.size() != b.arrays.size()
+      || a.values.size() != b.values.size())
+    return false;
+
+  for (size_t i = 0; i < a.arrays.size(); i++) {
+    auto &x = a.arrays[i];
+    auto &y = b.arrays[i];
+    if (x.param != y.param || x.numBytes != y.numBytes
+        || x.numItems != y.numItems || !sameBytes(x, y))
+      return false;
+  }
+
+  for (size_t i = 0; i < a.values.size(); i++) {
+    if (a.values[i]->name() != b.values[i]->name()
+        || a.values[i]->value() != b.values[i]->value())
+      return false;
+  }
+
+  return true;
+}
+
+void collectGeometries(Node &node,
+    std::unordered_set<Node *> &visited,
+    std::vector<NodePtr> &geometries)
+{
+  for (auto &c : node.children()) {
+    auto &child = c.second;
+    if (!visited.insert(child.get()).second)
+      continue;
+
+    if (child->type() == NodeType::GEOMETRY)
+      geometries.push_back(child);
+    else
+      collectGeometries(*child, visited, geometries);
+  }
+}
+
+} // namespace
+
+void Importer::deduplicateGeometries(Node &root)
+{
+  std::unordered_set<Node *> visited;
+  std::vector<NodePtr> geometries;
+  collectGeometries(root, visited, geometries);
+
+  std::unordered_map<uint64_t, std::vector<GeometryContent>> byShape;
+  for (auto &g : geometries) {
+    GeometryContent content;
+    if (describeGeometry(g, content))
+      byShape[shapeHash(content)].push_back(std::move(content));
+  }
+
+  size_t numRemoved = 0;
+  size_t numBytes = 0;
+  size_t numPrimitives = 0;
+
+  for (auto &shape : byShape) {
+    auto &candidates = shape.second;
+    if (candidates.size() < 2)
+      continue;
+
+    // Only now hash the contents, the first of each kind is kept
+    std::unordered_map<uint64_t, std::vector<GeometryContent *>> kept;
+    for (auto &c : candidates) {
+      c.hash = 0;
+      for (auto &a : c.arrays)
+        c.hash = hashArray(a, c.hash);
+
+      auto &same = kept[c.hash];
+      auto original = std::find_if(same.begin(), same.end(), [&](auto *k) {
+        return sameContent(*k, c);
+      });
+      if (original == same.end()) {
+        same.push_back(&c);
+        continue;
+      }
+
+      // Referenced by its former parents under its former name, each parent
+      // still gets its own instance of the (now shared) group
+      auto duplicate = c.node;
+      auto parents = duplicate->parents();
+      for (auto *parent : parents)
+        parent->add((*original)->node, duplicate->name());
+
+      numRemoved++;
+      numBytes += c.numBytes;
+      numPrimitives += c.numPrimitives;
+    }
+  }
+
+  if (numRemoved)
+    std::cout << fileName.name() << ": " << numRemoved << " of "
+              << geometries.size() << " geometries were duplicates, saving "
+              << numBytes / (1024.f * 1024.f) << " MB of arrays and "
+              << numPrimitives << " primitives of BVH builds" << std::endl;
+}
+
 struct FindCameraNode : public Visitor
 {
   FindCameraNode(std::shared_ptr<CameraMap> _sgFileCameras)
@@ -156,9 +447,9 @@ OSPSG_INTERFACE void importScene(
 
       // Parse entire generator json for children.  Only add valid values
       auto children = createNodeFromJSON(jG)->children();
-      std::function<void(Node &, const FlatMap<std::string, NodePtr> &)>
+      std::function<void(Node &, const NodeMap &)>
           setJsonValues = [&setJsonValues](Node &node,
-                          const FlatMap<std::string, NodePtr> &children) {
+                          const NodeMap &children) {
             for (auto &child : children) {
               auto &cn = child.second;
               if (cn->value().valid()) {
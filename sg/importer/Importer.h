@@ -11,6 +11,7 @@
 #include "sg/texture/Texture2D.h"
 #include "sg/scene/volume/Volume.h"
 #include "sg/generator/Generator.h"
+#include "SceneCache.h"
 // rkcommon
 #include "rkcommon/os/FileName.h"
 #include "rkcommon/utility/StringManip.h"
@@ -124,10 +125,30 @@ struct OSPSG_INTERFACE Importer : public Node
     scheduler = _scheduler;
   }
 
+  inline void setCacheFile(const std::string &_cacheFile)
+  {
+    cacheFile = _cacheFile;
+  }
+
   float pointSize{0.0f};
   bool importCameras{false};
+  bool deduplicateGeometry{true};
 
  protected:
+  // Collapses identical geometries below 'root' into one node, which takes
+  // the place of each duplicate in its parents.  RenderScene then builds a
+  // single group for them, instanced once per parent.
+  void deduplicateGeometries(Node &root);
+
+  // Scene cache, see SceneCache.h.  Importers call startSceneCache() before
+  // adding anything to the scene, and are done if it imported the subtree
+  // from a current cache.  Otherwise they call finishSceneCache() once
+  // 'rootNode' is complete.  Imports which also changed the cameras, lights or
+  // animations aren't cached.
+  bool startSceneCache();
+  void finishSceneCache(const Node &rootNode);
+  SceneCacheKey sceneCacheKey(const std::string &importer) const;
+
   rkcommon::FileName fileName;
   std::shared_ptr<sg::MaterialRegistry> materialRegistry = nullptr;
   // std::vector<NodePtr> *cameras = nullptr;
@@ -140,6 +161,15 @@ struct OSPSG_INTERFACE Importer : public Node
   int argc{0};
   char ** argv{nullptr};
   SchedulerPtr scheduler{nullptr};
+
+  std::string cacheFile; // empty if the import isn't cached
+  struct
+  {
+    uint32_t firstMaterial{0};
+    size_t numAnimations{0};
+    size_t numCameras{0};
+    size_t numLights{0};
+  } cacheStart;
 };
 
 // global assets catalogue
@@ -191,6 +221,8 @@ inline std::shared_ptr<Importer> getImporter(
 
   } else {
     nodeName = baseName + "_importer";
+    // The importer reads the cache of the file, if it has a current one
+    const auto cacheFile = sceneCacheFile(fullName, importer);
     auto importNode = createNodeAs<Importer>(nodeName, importer);
     importNode->createChild("count", "int", 0);
     importNode->child("count").setSGNoUI();
@@ -203,6 +235,7 @@ inline std::shared_ptr<Importer> getImporter(
       importNode->setVolumeParams(vp);
     }
     importNode->setFileName(fileName);
+    importNode->setCacheFile(cacheFile);
     cat.insert(AssetsCatalogue::value_type(fullName, importNode));
     root->add(importNode);
     return importNode;
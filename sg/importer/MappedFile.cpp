@@ -0,0 +1,126 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "MappedFile.h"
+// stl
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ospray {
+namespace sg {
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &fileName)
+{
+  std::shared_ptr<MappedFile> mapped(new MappedFile);
+
+  mapped->file = CreateFileA(fileName.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_FLAG_SEQUENTIAL_SCAN,
+      nullptr);
+  if (mapped->file == INVALID_HANDLE_VALUE) {
+    mapped->file = nullptr;
+    return nullptr;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(mapped->file, &size) || size.QuadPart == 0)
+    return nullptr;
+
+  mapped->mapping =
+      CreateFileMappingA(mapped->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapped->mapping)
+    return nullptr;
+
+  mapped->bytes = static_cast<const uint8_t *>(
+      MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!mapped->bytes)
+    return nullptr;
+
+  mapped->numBytes = size_t(size.QuadPart);
+  return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+  if (bytes)
+    UnmapViewOfFile(bytes);
+  if (mapping)
+    CloseHandle(mapping);
+  if (file)
+    CloseHandle(file);
+}
+
+void MappedFile::prefetchSequential(size_t, size_t) const
+{
+  // the file is opened for sequential scans already
+}
+
+void MappedFile::adviseNormal() const {}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &fileName)
+{
+  const int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat info;
+  void *bytes = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+    bytes = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping keeps the file open
+  close(fd);
+
+  if (bytes == MAP_FAILED)
+    return nullptr;
+
+  std::shared_ptr<MappedFile> mapped(new MappedFile);
+  mapped->bytes = static_cast<const uint8_t *>(bytes);
+  mapped->numBytes = size_t(info.st_size);
+  return mapped;
+}
+
+MappedFile::~MappedFile()
+{
+  if (bytes)
+    munmap(const_cast<uint8_t *>(bytes), numBytes);
+}
+
+void MappedFile::prefetchSequential(size_t offset, size_t length) const
+{
+  // madvise() needs page aligned addresses
+  const size_t page = size_t(sysconf(_SC_PAGESIZE));
+  const size_t begin = offset / page * page;
+  const size_t end = std::min(offset + length, numBytes);
+  if (begin >= end)
+    return;
+
+  auto *start = const_cast<uint8_t *>(bytes) + begin;
+  madvise(start, end - begin, MADV_SEQUENTIAL);
+  madvise(start, end - begin, MADV_WILLNEED);
+}
+
+void MappedFile::adviseNormal() const
+{
+  madvise(const_cast<uint8_t *>(bytes), numBytes, MADV_NORMAL);
+}
+
+#endif
+
+} // namespace sg
+} // namespace ospray
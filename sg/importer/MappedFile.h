@@ -0,0 +1,59 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "sg/Node.h" // for OSPSG_INTERFACE
+// stl
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ospray {
+namespace sg {
+
+// Read-only view of a whole file, mapped into memory.  Pages are only read
+// on first access and belong to the page cache, not to the process, so large
+// files don't need a second copy on the heap.  Shared by the importers and
+// the data they hand to OSPRay without copying.
+struct OSPSG_INTERFACE MappedFile
+{
+  // nullptr if the file can't be mapped (ie. missing or empty)
+  static std::shared_ptr<MappedFile> open(const std::string &fileName);
+
+  ~MappedFile();
+
+  const uint8_t *data() const;
+  size_t size() const;
+
+  // Hints that the range is about to be read front to back, to read ahead of
+  // the accesses and in large requests
+  void prefetchSequential(size_t offset, size_t numBytes) const;
+  // Back to default paging, for random accesses
+  void adviseNormal() const;
+
+ private:
+  MappedFile() = default;
+
+  const uint8_t *bytes{nullptr};
+  size_t numBytes{0};
+#ifdef _WIN32
+  void *file{nullptr};
+  void *mapping{nullptr};
+#endif
+};
+
+// Inlined definitions ////////////////////////////////////////////////////
+
+inline const uint8_t *MappedFile::data() const
+{
+  return bytes;
+}
+
+inline size_t MappedFile::size() const
+{
+  return numBytes;
+}
+
+} // namespace sg
+} // namespace ospray
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "Importer.h"
+#include "OBJ/ObjParser.h"
 // tiny_obj_loader
 #include "tiny_obj_loader.h"
 // rkcommon
@@ -17,6 +18,9 @@ namespace ospray {
     ~OBJImporter() override = default;
 
     void importScene() override;
+
+   private:
+    void importWithTinyObj(Node &rootNode);
   };
 
   OSP_REGISTER_SG_NODE_NAME(OBJImporter, importer_obj);
@@ -146,13 +150,13 @@ namespace ospray {
     return {};
   }
 
-  static std::vector<NodePtr> createMaterials(const OBJData &objData,
-                                              FileName fileName)
+  static std::vector<NodePtr> createMaterials(
+      const std::vector<tinyobj::material_t> &materials, FileName fileName)
   {
     std::vector<NodePtr> retval;
     const std::string containingPath = fileName.path();
 
-    for (const auto &m : objData.materials) {
+    for (const auto &m : materials) {
       std::vector<NodePtr> paramNodes;
       std::string matType{"obj"};
       // first check the type and parameters for this material.
@@ -321,6 +325,78 @@ namespace ospray {
     return retval;
   }
 
+  static void createMeshData(Geometry &mesh)
+  {
+    mesh.createChildData("material", mesh.mIDs, true);
+    mesh.child("material").setSGOnly();
+
+    mesh.createChildData("vertex.position", mesh.positions, true);
+    mesh.createChildData("index", mesh.quad_vi, true);
+    if (!mesh.normals.empty())
+      mesh.createChildData("vertex.normal", mesh.normals, true);
+    if (!mesh.vt.empty())
+      mesh.createChildData("vertex.texcoord", mesh.vt, true);
+  }
+
+  static void addMaterials(
+      const std::vector<tinyobj::material_t> &materials,
+      FileName fileName,
+      MaterialRegistry &materialRegistry)
+  {
+    auto materialNodes = createMaterials(materials, fileName);
+    // If the model provided no materials, create a default
+    if (materialNodes.empty())
+      materialNodes.emplace_back(createNode("default", "obj"));
+
+    for (auto m : materialNodes)
+      materialRegistry.add(m);
+  }
+
+  // Imports the meshes read by the multithreaded parser.  Returns false for
+  // files it can't read, which are left to tinyobj.
+  static bool importParsed(FileName fileName,
+      MaterialRegistry &materialRegistry,
+      Node &rootNode)
+  {
+    ObjParser parser;
+    if (!parser.parse(fileName))
+      return false;
+
+    size_t numQuads = 0;
+    size_t numTriangles = 0;
+    for (auto &shape : parser.shapes()) {
+      numQuads += shape.numQuads;
+      numTriangles += shape.numFaces - shape.numQuads;
+    }
+    std::cout << "... found " << numTriangles << " triangles "
+              << "and " << numQuads << " quads.\n";
+    if (!parser.warnings().empty()) {
+      std::cerr << "#ospsg: obj parsing warning(s)...\n"
+                << parser.warnings() << std::endl;
+    }
+
+    size_t baseMaterialOffset = materialRegistry.baseMaterialOffSet();
+    addMaterials(parser.materials(), fileName, materialRegistry);
+
+    std::vector<std::shared_ptr<Geometry>> meshNodes;
+    std::vector<Geometry *> meshes;
+    int shapeId = 0;
+    for (auto &shape : parser.shapes()) {
+      auto name = std::to_string(shapeId++) + '_' + shape.name;
+      meshNodes.push_back(createNodeAs<Geometry>(name, "geometry_triangles"));
+      meshes.push_back(meshNodes.back().get());
+    }
+
+    parser.fillGeometries(meshes, uint32_t(baseMaterialOffset));
+
+    for (auto &mesh : meshNodes) {
+      createMeshData(*mesh);
+      rootNode.add(mesh);
+    }
+
+    return true;
+  }
+
   // OBJImporter definitions /////////////////////////////////////////////
 
   void OBJImporter::importScene()
@@ -330,17 +406,29 @@ namespace ospray {
     std::string baseName = fileName.name() + "_rootXfm";
     auto rootNode = createNode(baseName, "transform");
 
-    auto objData = loadFromFile(fileName);
+    if (startSceneCache())
+      return;
+    if (!importParsed(fileName, *materialRegistry, *rootNode))
+      importWithTinyObj(*rootNode);
 
-    auto materialNodes = createMaterials(objData, fileName);
-    // If the model provided no materials, create a default
-    if (materialNodes.empty())
-      materialNodes.emplace_back(createNode("default", "obj"));
+    if (deduplicateGeometry)
+      deduplicateGeometries(*rootNode);
 
-    size_t baseMaterialOffset = materialRegistry->baseMaterialOffSet();
+    // Finally, add node hierarchy to importer parent
+    add(rootNode);
+    finishSceneCache(*rootNode);
 
-    for (auto m : materialNodes)
-      materialRegistry->add(m);
+    std::cout << "...finished import!\n";
+  }
+
+  // Polygons, and anything else the parser doesn't read, go through tinyobj
+  // which triangulates them
+  void OBJImporter::importWithTinyObj(Node &rootNode)
+  {
+    auto objData = loadFromFile(fileName);
+
+    size_t baseMaterialOffset = materialRegistry->baseMaterialOffSet();
+    addMaterials(objData.materials, fileName, *materialRegistry);
 
     auto &attrib = objData.attrib;
 
@@ -398,23 +486,10 @@ namespace ospray {
           shape.mesh.material_ids.end(),
           mIDs.begin(),
           [&](int i) { return i + baseMaterialOffset; });
-      mesh->createChildData("material", mIDs, true);
-      mesh->child("material").setSGOnly();
-
-      mesh->createChildData("vertex.position", v, true);
-      mesh->createChildData("index", vi, true);
-      if (!vn.empty())
-        mesh->createChildData("vertex.normal", vn, true);
-      if (!vt.empty())
-        mesh->createChildData("vertex.texcoord", vt, true);
+      createMeshData(*mesh);
 
-      rootNode->add(mesh);
+      rootNode.add(mesh);
     }
-
-    // Finally, add node hierarchy to importer parent
-    add(rootNode);
-
-    std::cout << "...finished import!\n";
   }
 
   }  // namespace sg
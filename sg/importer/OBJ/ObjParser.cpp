@@ -0,0 +1,685 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "ObjParser.h"
+#include "../MappedFile.h"
+#include "sg/scene/geometry/Geometry.h"
+// rkcommon
+#include "rkcommon/tasking/parallel_for.h"
+// stl
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace ospray {
+namespace sg {
+
+// Chunks are large enough to amortize the tasks, small enough to balance them
+static constexpr size_t chunkSize = 32 << 20;
+
+// Attributes referenced by a face corner, in the order of the OBJ syntax
+enum Attribute
+{
+  POSITION = 0,
+  TEXCOORD,
+  NORMAL,
+  NUM_ATTRIBUTES
+};
+
+// Helper functions ///////////////////////////////////////////////////////////
+
+static inline bool isSpace(char c)
+{
+  return c == ' ' || c == '\t';
+}
+
+static inline bool isDigit(char c)
+{
+  return unsigned(c - '0') < 10u;
+}
+
+static inline const char *skipSpace(const char *p, const char *end)
+{
+  while (p < end && isSpace(*p))
+    ++p;
+  return p;
+}
+
+static inline const char *skipToken(const char *p, const char *end)
+{
+  while (p < end && !isSpace(*p))
+    ++p;
+  return p;
+}
+
+// Reads the next token as a decimal number, without strtod() and its locale.
+// Like tinyobj, a token which isn't a number reads as 0.
+static float parseFloat(const char *&p, const char *end)
+{
+  static const double exact[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+      1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+      1e21, 1e22};
+  // further digits don't change a float
+  const uint64_t maxMantissa = 100000000000000000ull;
+
+  p = skipSpace(p, end);
+  const char *s = p;
+  p = skipToken(p, end);
+
+  bool negative = false;
+  if (s < p && (*s == '+' || *s == '-'))
+    negative = *s++ == '-';
+
+  uint64_t mantissa = 0;
+  int exponent = 0;
+  int digits = 0;
+  for (; s < p && isDigit(*s); ++s, ++digits) {
+    if (mantissa < maxMantissa)
+      mantissa = mantissa * 10 + (*s - '0');
+    else
+      ++exponent;
+  }
+  if (s < p && *s == '.') {
+    for (++s; s < p && isDigit(*s); ++s, ++digits) {
+      if (mantissa < maxMantissa) {
+        mantissa = mantissa * 10 + (*s - '0');
+        --exponent;
+      }
+    }
+  }
+  if (digits == 0)
+    return 0.f;
+
+  if (s < p && (*s == 'e' || *s == 'E')) {
+    ++s;
+    bool negativeExponent = false;
+    if (s < p && (*s == '+' || *s == '-'))
+      negativeExponent = *s++ == '-';
+    int e = 0;
+    for (; s < p && isDigit(*s); ++s)
+      if (e < 10000)
+        e = e * 10 + (*s - '0');
+    exponent += negativeExponent ? -e : e;
+  }
+
+  double value = double(mantissa);
+  if (exponent < 0 && exponent >= -22)
+    value /= exact[-exponent];
+  else if (exponent > 0 && exponent <= 22)
+    value *= exact[exponent];
+  else if (exponent != 0)
+    value *= std::pow(10.0, exponent);
+
+  return float(negative ? -value : value);
+}
+
+// atoi() on the characters up to 'end', leaves 'p' after the digits.  Values
+// beyond the range of an index saturate, see Chunk::fixIndex().
+static int64_t parseInt(const char *&p, const char *end)
+{
+  const int64_t limit = int64_t(std::numeric_limits<int>::max()) + 1;
+  bool negative = false;
+  if (p < end && (*p == '+' || *p == '-'))
+    negative = *p++ == '-';
+  int64_t value = 0;
+  for (; p < end && isDigit(*p); ++p)
+    value = std::min(value * 10 + (*p - '0'), limit);
+  return negative ? -value : value;
+}
+
+// Chunk definitions //////////////////////////////////////////////////////////
+
+struct ObjParser::Chunk
+{
+  struct Corner
+  {
+    int index[NUM_ATTRIBUTES]{-1, -1, -1};
+  };
+
+  // Number of faces, corners and quads parsed so far
+  struct Cursor
+  {
+    size_t face{0};
+    size_t corner{0};
+    size_t quad{0};
+  };
+
+  // Lines which depend on the state of the preceding chunks, for merge()
+  struct Event
+  {
+    enum Type
+    {
+      GROUP,
+      OBJECT,
+      USEMTL,
+      MTLLIB
+    };
+
+    Type type;
+    Cursor at;
+    std::string text;
+  };
+
+  void parse();
+
+  Cursor cursor() const;
+
+  const char *begin{nullptr};
+  const char *end{nullptr};
+
+  std::vector<vec3f> positions;
+  std::vector<vec3f> normals;
+  std::vector<vec2f> texcoords;
+
+  std::vector<Corner> corners;
+  std::vector<uint8_t> faceSizes;
+  size_t numQuads{0};
+  std::vector<Event> events;
+
+  // Relative indices are resolved against the chunk's own attributes while
+  // parsing, these (corner * NUM_ATTRIBUTES + attribute) still need the
+  // preceding chunks' counts added
+  std::vector<size_t> relative;
+  int maxIndex[NUM_ATTRIBUTES]{-1, -1, -1}; // of absolute indices
+  size_t base[NUM_ATTRIBUTES]{0, 0, 0}; // of the chunk's attributes
+
+  size_t degenerateFaces{0};
+  bool unsupported{false};
+  // an index beyond what any file can address
+  bool indexOutOfRange{false};
+
+ private:
+  bool parseLine(const char *p, const char *end);
+  bool parseFace(const char *p, const char *end);
+  bool fixIndex(
+      int64_t value, Attribute attribute, int &index, bool &isRelative);
+  void addEvent(Event::Type type, std::string text);
+};
+
+void ObjParser::Chunk::parse()
+{
+  for (const char *line = begin; line < end;) {
+    // tinyobj ends lines on '\r' as well
+    const char *lineEnd = line;
+    while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r')
+      ++lineEnd;
+
+    if (!parseLine(skipSpace(line, lineEnd), lineEnd)) {
+      unsupported = true;
+      return;
+    }
+    line = lineEnd + 1;
+  }
+}
+
+ObjParser::Chunk::Cursor ObjParser::Chunk::cursor() const
+{
+  Cursor at;
+  at.face = faceSizes.size();
+  at.corner = corners.size();
+  at.quad = numQuads;
+  return at;
+}
+
+bool ObjParser::Chunk::parseLine(const char *p, const char *end)
+{
+  // all statements we read are at least a letter and a space
+  if (end - p < 2)
+    return true;
+
+  switch (p[0]) {
+  case 'v':
+    if (isSpace(p[1])) {
+      p += 2;
+      const float x = parseFloat(p, end);
+      const float y = parseFloat(p, end);
+      const float z = parseFloat(p, end);
+      positions.emplace_back(x, y, z);
+    } else if (p[1] == 'n' && end - p > 2 && isSpace(p[2])) {
+      p += 3;
+      const float x = parseFloat(p, end);
+      const float y = parseFloat(p, end);
+      const float z = parseFloat(p, end);
+      normals.emplace_back(x, y, z);
+    } else if (p[1] == 't' && end - p > 2 && isSpace(p[2])) {
+      p += 3;
+      const float x = parseFloat(p, end);
+      const float y = parseFloat(p, end);
+      texcoords.emplace_back(x, y);
+    }
+    return true;
+  case 'f':
+    return !isSpace(p[1]) || parseFace(p + 2, end);
+  case 'g':
+    if (isSpace(p[1])) {
+      // tinyobj joins multiple group names with a space
+      std::string name;
+      for (p = skipSpace(p + 2, end); p < end; p = skipSpace(p, end)) {
+        const char *nameEnd = skipToken(p, end);
+        if (!name.empty())
+          name += ' ';
+        name.append(p, nameEnd);
+        p = nameEnd;
+      }
+      addEvent(Event::GROUP, std::move(name));
+    }
+    return true;
+  case 'o':
+    if (isSpace(p[1]))
+      addEvent(Event::OBJECT, std::string(p + 2, end));
+    return true;
+  case 'u':
+    if (end - p >= 6 && std::strncmp(p, "usemtl", 6) == 0) {
+      p = skipSpace(p + 6, end);
+      addEvent(Event::USEMTL, std::string(p, skipToken(p, end)));
+    }
+    return true;
+  case 'm':
+    if (end - p > 6 && std::strncmp(p, "mtllib", 6) == 0 && isSpace(p[6]))
+      addEvent(Event::MTLLIB, std::string(p + 7, end));
+    return true;
+  default:
+    // comments, lines, points, smoothing groups, tags...
+    return true;
+  }
+}
+
+bool ObjParser::Chunk::parseFace(const char *p, const char *end)
+{
+  Corner face[4];
+  bool isRelative[4][NUM_ATTRIBUTES]{};
+  int numCorners = 0;
+
+  for (p = skipSpace(p, end); p < end; p = skipSpace(p, end)) {
+    // polygons are triangulated by tinyobj
+    if (numCorners == 4)
+      return false;
+    auto &corner = face[numCorners];
+    auto *relativeIndex = isRelative[numCorners++];
+
+    // i, i/j, i//k or i/j/k
+    Attribute attribute = POSITION;
+    while (true) {
+      if (!fixIndex(parseInt(p, end),
+              attribute,
+              corner.index[attribute],
+              relativeIndex[attribute]))
+        return false;
+      while (p < end && *p != '/' && !isSpace(*p))
+        ++p;
+      if (p == end || *p != '/' || attribute == NORMAL)
+        break;
+      ++p;
+      if (attribute == POSITION && p < end && *p == '/') {
+        ++p;
+        attribute = NORMAL;
+      } else
+        attribute = Attribute(attribute + 1);
+    }
+    p = skipToken(p, end);
+  }
+
+  if (numCorners < 3) {
+    // skipped by tinyobj as well
+    ++degenerateFaces;
+    return true;
+  }
+
+  for (int c = 0; c < numCorners; ++c) {
+    for (int a = 0; a < NUM_ATTRIBUTES; ++a)
+      if (isRelative[c][a])
+        relative.push_back(corners.size() * NUM_ATTRIBUTES + a);
+    corners.push_back(face[c]);
+  }
+  faceSizes.push_back(uint8_t(numCorners));
+  numQuads += numCorners == 4;
+
+  return true;
+}
+
+// Makes 'value' zero based, negative values count back from the last
+// attribute read so far
+bool ObjParser::Chunk::fixIndex(
+    int64_t value, Attribute attribute, int &index, bool &isRelative)
+{
+  // zero is not allowed by the spec, tinyobj fails on it too
+  if (value == 0)
+    return false;
+
+  // Files have at most INT_MAX attributes (see resolveIndices()), so valid
+  // indices, relative ones resolved against this chunk too, fit an int
+  const int64_t maxValue = std::numeric_limits<int>::max();
+  isRelative = value < 0;
+  if (isRelative) {
+    const size_t count[] = {
+        positions.size(), texcoords.size(), normals.size()};
+    value += int64_t(count[attribute]);
+  }
+  if (value < -maxValue || value > maxValue) {
+    indexOutOfRange = true;
+    return true;
+  }
+
+  if (isRelative)
+    index = int(value);
+  else {
+    index = int(value - 1);
+    maxIndex[attribute] = std::max(maxIndex[attribute], index);
+  }
+  return true;
+}
+
+void ObjParser::Chunk::addEvent(Event::Type type, std::string text)
+{
+  Event event;
+  event.type = type;
+  event.at = cursor();
+  event.text = std::move(text);
+  events.push_back(std::move(event));
+}
+
+// ObjParser definitions //////////////////////////////////////////////////////
+
+ObjParser::ObjParser() = default;
+
+ObjParser::~ObjParser() = default;
+
+bool ObjParser::parse(const FileName &fileName)
+{
+  chunks.clear();
+  segments.clear();
+  shapeList.clear();
+  materialList.clear();
+  warningText.clear();
+
+  auto file = MappedFile::open(fileName.str());
+  if (!file)
+    return false;
+
+  // Cut the file into chunks of whole lines
+  const char *data = reinterpret_cast<const char *>(file->data());
+  const char *fileEnd = data + file->size();
+  const size_t numChunks = (file->size() + chunkSize - 1) / chunkSize;
+
+  const char *begin = data;
+  for (size_t i = 1; i <= numChunks && begin < fileEnd; ++i) {
+    const char *end = std::max(begin, data + file->size() / numChunks * i);
+    if (i == numChunks || end >= fileEnd)
+      end = fileEnd;
+    else {
+      auto *newLine = std::memchr(end, '\n', fileEnd - end);
+      end = newLine ? static_cast<const char *>(newLine) + 1 : fileEnd;
+    }
+
+    chunks.emplace_back(new Chunk);
+    chunks.back()->begin = begin;
+    chunks.back()->end = end;
+    begin = end;
+  }
+
+  tasking::parallel_for(chunks.size(), [&](size_t i) {
+    auto &chunk = *chunks[i];
+    file->prefetchSequential(chunk.begin - data, chunk.end - chunk.begin);
+    chunk.parse();
+  });
+
+  size_t degenerateFaces = 0;
+  for (auto &chunk : chunks) {
+    if (chunk->unsupported) {
+      chunks.clear();
+      return false;
+    }
+    degenerateFaces += chunk->degenerateFaces;
+    // the file is unmapped on return
+    chunk->begin = chunk->end = nullptr;
+  }
+
+  resolveIndices(fileName.str());
+  merge(fileName.path());
+  findAttributes();
+
+  if (degenerateFaces) {
+    warningText += "Skipped " + std::to_string(degenerateFaces)
+        + " degenerated face(s) with less than 3 vertices\n";
+  }
+
+  return true;
+}
+
+// Gathers the chunks' attributes and makes their indices file wide
+void ObjParser::resolveIndices(const std::string &fileName)
+{
+  size_t count[NUM_ATTRIBUTES] = {0, 0, 0};
+  for (auto &chunk : chunks) {
+    std::copy(count, count + NUM_ATTRIBUTES, chunk->base);
+    count[POSITION] += chunk->positions.size();
+    count[TEXCOORD] += chunk->texcoords.size();
+    count[NORMAL] += chunk->normals.size();
+  }
+  for (size_t n : count) {
+    if (n > size_t(std::numeric_limits<int>::max())) {
+      throw std::runtime_error(
+          "OBJ file '" + fileName + "' has too many vertex attributes");
+    }
+  }
+
+  positions.resize(count[POSITION]);
+  texcoords.resize(count[TEXCOORD]);
+  normals.resize(count[NORMAL]);
+
+  std::vector<char> outOfRange(chunks.size(), false);
+  tasking::parallel_for(chunks.size(), [&](size_t i) {
+    auto &chunk = *chunks[i];
+
+    std::copy(chunk.positions.begin(),
+        chunk.positions.end(),
+        positions.begin() + chunk.base[POSITION]);
+    std::copy(chunk.texcoords.begin(),
+        chunk.texcoords.end(),
+        texcoords.begin() + chunk.base[TEXCOORD]);
+    std::copy(chunk.normals.begin(),
+        chunk.normals.end(),
+        normals.begin() + chunk.base[NORMAL]);
+    std::vector<vec3f>().swap(chunk.positions);
+    std::vector<vec2f>().swap(chunk.texcoords);
+    std::vector<vec3f>().swap(chunk.normals);
+
+    if (chunk.indexOutOfRange)
+      outOfRange[i] = true;
+
+    for (size_t r : chunk.relative) {
+      const size_t a = r % NUM_ATTRIBUTES;
+      int &index = chunk.corners[r / NUM_ATTRIBUTES].index[a];
+      const int64_t resolved = int64_t(index) + int64_t(chunk.base[a]);
+      if (resolved < 0 || uint64_t(resolved) >= count[a])
+        outOfRange[i] = true;
+      else
+        index = int(resolved);
+    }
+    std::vector<size_t>().swap(chunk.relative);
+
+    for (size_t a = 0; a < NUM_ATTRIBUTES; ++a)
+      if (chunk.maxIndex[a] >= 0 && size_t(chunk.maxIndex[a]) >= count[a])
+        outOfRange[i] = true;
+  });
+
+  if (std::find(outOfRange.begin(), outOfRange.end(), true)
+      != outOfRange.end()) {
+    throw std::runtime_error(
+        "OBJ file '" + fileName + "' has face indices out of range");
+  }
+}
+
+// Replays the group, object and material statements in file order, to cut the
+// chunks' faces into segments of shapes like tinyobj::LoadObj()
+void ObjParser::merge(const std::string &mtlBaseDir)
+{
+  tinyobj::MaterialFileReader readMaterials(mtlBaseDir);
+  std::map<std::string, int> materialMap;
+
+  std::string name;
+  int material = -1;
+  // a group or object statement starts a new shape with the next face
+  bool shapeOpen = false;
+
+  auto addFaces = [&](const Chunk &chunk,
+                      const Chunk::Cursor &from,
+                      const Chunk::Cursor &to) {
+    if (from.face == to.face)
+      return;
+    if (!shapeOpen) {
+      Shape shape;
+      shape.name = name;
+      shape.hasNormals = true;
+      shape.hasTexcoords = true;
+      shapeList.push_back(shape);
+      shapeOpen = true;
+    }
+    auto &shape = shapeList.back();
+
+    Segment segment;
+    segment.chunk = &chunk;
+    segment.firstFace = from.face;
+    segment.numFaces = to.face - from.face;
+    segment.firstCorner = from.corner;
+    segment.numCorners = to.corner - from.corner;
+    segment.material = material;
+    segment.shape = shapeList.size() - 1;
+    segment.faceOffset = shape.numFaces;
+    segment.cornerOffset = shape.numCorners;
+    segments.push_back(segment);
+
+    shape.numFaces += segment.numFaces;
+    shape.numCorners += segment.numCorners;
+    shape.numQuads += to.quad - from.quad;
+  };
+
+  for (auto &chunk : chunks) {
+    Chunk::Cursor at;
+    for (auto &event : chunk->events) {
+      addFaces(*chunk, at, event.at);
+      at = event.at;
+
+      switch (event.type) {
+      case Chunk::Event::GROUP:
+      case Chunk::Event::OBJECT:
+        name = event.text;
+        shapeOpen = false;
+        break;
+      case Chunk::Event::USEMTL: {
+        auto found = materialMap.find(event.text);
+        if (found == materialMap.end()) {
+          warningText +=
+              "material [ '" + event.text + "' ] not found in .mtl\n";
+          material = -1;
+        } else
+          material = found->second;
+        break;
+      }
+      case Chunk::Event::MTLLIB: {
+        std::istringstream fileNames(event.text);
+        std::string mtlFile;
+        bool loaded = false;
+        bool any = false;
+        while (!loaded && fileNames >> mtlFile) {
+          std::string warn;
+          std::string err;
+          any = true;
+          loaded = readMaterials(
+              mtlFile, &materialList, &materialMap, &warn, &err);
+          warningText += warn + err;
+        }
+        if (!any) {
+          warningText += "Looks like empty filename for mtllib. "
+                         "Use default material.\n";
+        } else if (!loaded) {
+          warningText +=
+              "Failed to load material file(s). Use default material.\n";
+        }
+        break;
+      }
+      }
+    }
+    addFaces(*chunk, at, chunk->cursor());
+    std::vector<Chunk::Event>().swap(chunk->events);
+  }
+}
+
+// Normals and texcoords are only kept for shapes with them on every corner
+void ObjParser::findAttributes()
+{
+  std::vector<uint8_t> found(segments.size());
+  tasking::parallel_for(segments.size(), [&](size_t i) {
+    const auto &segment = segments[i];
+    const auto *corner = segment.chunk->corners.data() + segment.firstCorner;
+    bool hasNormals = true;
+    bool hasTexcoords = true;
+    for (size_t c = 0; c < segment.numCorners; ++c) {
+      hasNormals &= corner[c].index[NORMAL] >= 0;
+      hasTexcoords &= corner[c].index[TEXCOORD] >= 0;
+    }
+    found[i] = uint8_t(hasNormals) | uint8_t(hasTexcoords) << 1;
+  });
+
+  for (size_t i = 0; i < segments.size(); ++i) {
+    auto &shape = shapeList[segments[i].shape];
+    shape.hasNormals &= (found[i] & 1) != 0;
+    shape.hasTexcoords &= (found[i] & 2) != 0;
+  }
+}
+
+void ObjParser::fillGeometries(
+    const std::vector<Geometry *> &meshes, uint32_t materialOffset) const
+{
+  tasking::parallel_for(shapeList.size(), [&](size_t i) {
+    const auto &shape = shapeList[i];
+    auto &mesh = *meshes[i];
+    mesh.positions.resize(shape.numCorners);
+    if (shape.hasNormals)
+      mesh.normals.resize(shape.numCorners);
+    if (shape.hasTexcoords)
+      mesh.vt.resize(shape.numCorners);
+    mesh.quad_vi.resize(shape.numFaces);
+    mesh.mIDs.resize(shape.numFaces);
+  });
+
+  // OSPRay doesn't support separate arrays for vertex, normal & texcoord
+  // indices.  So, every corner gets its own vertex, and triangles duplicate
+  // the last index of a quad.
+  tasking::parallel_for(segments.size(), [&](size_t i) {
+    const auto &segment = segments[i];
+    const auto &chunk = *segment.chunk;
+    const auto &shape = shapeList[segment.shape];
+    auto &mesh = *meshes[segment.shape];
+
+    const uint32_t mID = uint32_t(segment.material) + materialOffset;
+    auto c = uint32_t(segment.cornerOffset);
+    for (size_t f = 0; f < segment.numFaces; ++f) {
+      const uint8_t numCorners = chunk.faceSizes[segment.firstFace + f];
+      // when a Quad then use same splitting diagonal in OSPRay/Embree as
+      // tinyOBJ would use
+      mesh.quad_vi[segment.faceOffset + f] = numCorners == 4
+          ? vec4ui(c + 3, c, c + 1, c + 2)
+          : vec4ui(c, c + 1, c + 2, c + 2);
+      mesh.mIDs[segment.faceOffset + f] = mID;
+      c += numCorners;
+    }
+
+    const auto *corner = chunk.corners.data() + segment.firstCorner;
+    for (size_t k = 0; k < segment.numCorners; ++k) {
+      const size_t dst = segment.cornerOffset + k;
+      mesh.positions[dst] = positions[corner[k].index[POSITION]];
+      if (shape.hasNormals)
+        mesh.normals[dst] = normals[corner[k].index[NORMAL]];
+      if (shape.hasTexcoords)
+        mesh.vt[dst] = texcoords[corner[k].index[TEXCOORD]];
+    }
+  });
+}
+
+} // namespace sg
+} // namespace ospray
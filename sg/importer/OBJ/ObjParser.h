@@ -0,0 +1,109 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "sg/Node.h"
+// tiny_obj_loader
+#include "tiny_obj_loader.h"
+// rkcommon
+#include "rkcommon/os/FileName.h"
+// stl
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ospray {
+namespace sg {
+
+struct Geometry;
+
+// Multithreaded reader of the triangle and quad meshes of an OBJ file.  The
+// file is mapped and split into line aligned chunks which are parsed in
+// parallel, then the chunks' faces are merged into shapes the way
+// tinyobj::LoadObj() groups them (without triangulation), and written straight
+// into the arrays of one Geometry per shape.
+//
+// Polygons with more than 4 vertices and malformed faces are left to tinyobj,
+// parse() returns false for them.
+struct ObjParser
+{
+  struct Shape
+  {
+    std::string name;
+    size_t numFaces{0};
+    size_t numQuads{0};
+    size_t numCorners{0};
+    // only if all corners of the shape have them
+    bool hasNormals{false};
+    bool hasTexcoords{false};
+  };
+
+  ObjParser();
+  ~ObjParser();
+
+  // Throws on indices out of range
+  bool parse(const FileName &fileName);
+
+  const std::vector<Shape> &shapes() const;
+  const std::vector<tinyobj::material_t> &materials() const;
+  const std::string &warnings() const;
+
+  // Fills positions, normals, texcoords, quad indices and material IDs of
+  // 'meshes', one per shape
+  void fillGeometries(
+      const std::vector<Geometry *> &meshes, uint32_t materialOffset) const;
+
+ private:
+  struct Chunk;
+
+  // Faces of a chunk which go to the same shape with the same material
+  struct Segment
+  {
+    const Chunk *chunk{nullptr};
+    size_t firstFace{0};
+    size_t numFaces{0};
+    size_t firstCorner{0};
+    size_t numCorners{0};
+    int material{-1};
+
+    size_t shape{0};
+    size_t faceOffset{0}; // in the shape's arrays
+    size_t cornerOffset{0};
+  };
+
+  void resolveIndices(const std::string &fileName);
+  void merge(const std::string &mtlBaseDir);
+  void findAttributes();
+
+  std::vector<std::unique_ptr<Chunk>> chunks;
+  std::vector<Segment> segments;
+
+  std::vector<vec3f> positions;
+  std::vector<vec3f> normals;
+  std::vector<vec2f> texcoords;
+
+  std::vector<Shape> shapeList;
+  std::vector<tinyobj::material_t> materialList;
+  std::string warningText;
+};
+
+// Inlined definitions ////////////////////////////////////////////////////
+
+inline const std::vector<ObjParser::Shape> &ObjParser::shapes() const
+{
+  return shapeList;
+}
+
+inline const std::vector<tinyobj::material_t> &ObjParser::materials() const
+{
+  return materialList;
+}
+
+inline const std::string &ObjParser::warnings() const
+{
+  return warningText;
+}
+
+} // namespace sg
+} // namespace ospray
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "Importer.h"
+#include "sg/scene/geometry/Geometry.h"
 // rkcommon
 #include "rkcommon/os/FileName.h"
 
@@ -279,11 +280,13 @@ int readPCDBodyAscii(const FileName &fileName, PCDData &pcdData)
   fs.seekg(headerData.dataId);
 
   unsigned int current = 0;
-  std::vector<vec3f> centers;
-  std::vector<vec4f> colors;
-
   pcdData.spheres = createNode("spheres", "geometry_spheres");
 
+  // Kept in the geometry and shared with OSPRay
+  auto &spheres = *pcdData.spheres->nodeAs<Geometry>();
+  auto &centers = spheres.positions;
+  auto &colors = spheres.vc;
+
   try {
     while (current < headerData.numPoints && !fs.eof()) {
       std::string line;
@@ -656,8 +659,8 @@ int readPCDBodyBinary(const FileName &fileName, PCDData &pcdData)
     colors.push_back(color);
   }
 
-  pcdData.spheres->createChildData("sphere.position", centers);
-  pcdData.spheres->createChildData("color", colors);
+  pcdData.spheres->createChildData("sphere.position", centers, true);
+  pcdData.spheres->createChildData("color", colors, true);
 
   std::cout << "Number of rendered points : " << centers.size() << std::endl;
 
@@ -685,6 +688,9 @@ int readPCD(const FileName &fileName, PCDData &pcdData)
 
 void PCDImporter::importScene()
 {
+  if (startSceneCache())
+    return;
+
   PCDData pcdData;
   auto res = readPCD(fileName, pcdData);
   if (res < 0)
@@ -702,8 +708,9 @@ void PCDImporter::importScene()
 
   pcdData.spheres->child("radius").setValue(pointSize);
 
-  const std::vector<uint32_t> mID = {materialRegistry->baseMaterialOffSet()};
-  pcdData.spheres->createChildData("material", mID);
+  auto &spheres = *pcdData.spheres->nodeAs<Geometry>();
+  spheres.mIDs = {materialRegistry->baseMaterialOffSet()};
+  pcdData.spheres->createChildData("material", spheres.mIDs, true);
   pcdData.spheres->child("material").setSGOnly();
 
   auto mat = createNode("default-material-pcd", "obj");
@@ -722,6 +729,7 @@ void PCDImporter::importScene()
   rootNode->add(pcdData.spheres);
 
   add(rootNode);
+  finishSceneCache(*rootNode);
   std::cout << "Finished importing PCD file." << std::endl;
 }
 
@@ -0,0 +1,986 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "SceneCache.h"
+#include "HostArray.h"
+#include "Importer.h"
+#include "MappedFile.h"
+#include "sg/renderer/MaterialRegistry.h"
+#include "sg/texture/Texture2D.h"
+// stl
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+// stat, mkdir
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+namespace ospray {
+namespace sg {
+
+SceneCacheSettings sceneCacheSettings;
+
+namespace {
+
+// Bump an importer's version whenever the subtree it creates changes, to
+// invalidate the caches of its earlier imports
+const std::map<std::string, uint32_t> importerVersions = {
+    {"importer_obj", 1},
+    {"importer_pcd", 1},
+    {"importer_gltf", 1},
+    {"importer_raw", 1}};
+
+// File layout ////////////////////////////////////////////////////////////////
+//
+//   FileHeader
+//   key:       source, importer, settings, importer version, source size,
+//              modification time and a hash of its first and last bytes
+//   arrays:    items of the data parameters, each aligned to arrayAlignment
+//   structure: the import's materials, then its root (see SceneWriter)
+
+// Bump whenever the layout changes
+const uint32_t formatVersion = 3;
+const char fileMagic[8] = {'O', 'S', 'P', 'S', 'G', 'C', 'C', 'H'};
+const uint32_t byteOrderMark = 0x01020304;
+const uint64_t arrayAlignment = 64;
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t formatVersion;
+  uint32_t byteOrder;
+  uint64_t structureOffset;
+  uint64_t structureSize;
+};
+
+enum class Record : uint8_t
+{
+  REFERENCE, // to a node written before, for nodes with several parents
+  NODE,
+  DATA,
+  TEXTURE, // reloaded from its file
+  TEXELS // texture with its texels in the arrays
+};
+
+enum class ValueType : uint8_t
+{
+  NONE,
+  BOOL,
+  INT,
+  UCHAR,
+  UINT,
+  FLOAT,
+  STRING,
+  VEC2I,
+  VEC2F,
+  VEC3I,
+  VEC3F,
+  VEC4I,
+  VEC4F,
+  RANGE1F,
+  QUATERNIONF,
+  LINEAR2F,
+  AFFINE3F
+};
+
+enum NodeFlags : uint8_t
+{
+  SG_ONLY = 1,
+  SG_NO_UI = 2,
+  READ_ONLY = 4
+};
+
+// Item types of the cached data parameters
+#define CACHED_DATA_TYPES                                                      \
+  X(OSP_UCHAR, uint8_t)                                                        \
+  X(OSP_SHORT, int16_t)                                                        \
+  X(OSP_USHORT, uint16_t)                                                      \
+  X(OSP_INT, int)                                                              \
+  X(OSP_UINT, uint32_t)                                                        \
+  X(OSP_FLOAT, float)                                                          \
+  X(OSP_DOUBLE, double)                                                        \
+  X(OSP_VEC2I, vec2i)                                                          \
+  X(OSP_VEC3I, vec3i)                                                          \
+  X(OSP_VEC4I, vec4i)                                                          \
+  X(OSP_VEC2UI, vec2ui)                                                        \
+  X(OSP_VEC3UI, vec3ui)                                                        \
+  X(OSP_VEC4UI, vec4ui)                                                        \
+  X(OSP_VEC2F, vec2f)                                                          \
+  X(OSP_VEC3F, vec3f)                                                          \
+  X(OSP_VEC4F, vec4f)
+
+size_t itemBytesOf(OSPDataType format)
+{
+  switch (format) {
+#define X(FORMAT, T)                                                           \
+  case FORMAT:                                                                 \
+    return sizeof(T);
+    CACHED_DATA_TYPES
+#undef X
+  default:
+    return 0;
+  }
+}
+
+std::shared_ptr<Data> sharedData(
+    OSPDataType format, const vec3ul &numItems, const void *items)
+{
+  switch (format) {
+#define X(FORMAT, T)                                                           \
+  case FORMAT:                                                                 \
+    return std::make_shared<Data>(numItems, static_cast<const T *>(items), true);
+    CACHED_DATA_TYPES
+#undef X
+  default:
+    return nullptr;
+  }
+}
+
+#undef CACHED_DATA_TYPES
+
+// Serialization helpers //////////////////////////////////////////////////////
+
+struct ByteWriter
+{
+  template <typename T>
+  void put(const T &value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+    auto *p = reinterpret_cast<const uint8_t *>(&value);
+    bytes.insert(bytes.end(), p, p + sizeof(T));
+  }
+
+  void put(const std::string &s)
+  {
+    put(uint64_t(s.size()));
+    bytes.insert(bytes.end(), s.begin(), s.end());
+  }
+
+  std::vector<uint8_t> bytes;
+};
+
+// Reads back what ByteWriter wrote, throwing on reads past the end
+struct ByteReader
+{
+  template <typename T>
+  T get()
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "not a plain value");
+    need(sizeof(T));
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+  }
+
+  std::string getString()
+  {
+    const auto size = get<uint64_t>();
+    need(size);
+    std::string s(reinterpret_cast<const char *>(p), size);
+    p += size;
+    return s;
+  }
+
+  void need(uint64_t numBytes) const
+  {
+    if (uint64_t(end - p) < numBytes)
+      throw std::runtime_error("truncated file");
+  }
+
+  const uint8_t *p{nullptr};
+  const uint8_t *end{nullptr};
+};
+
+template <typename T>
+bool putValueAs(ByteWriter &out, const Any &value, ValueType type)
+{
+  if (!value.is<T>())
+    return false;
+  out.put(type);
+  out.put(value.get<T>());
+  return true;
+}
+
+// Rotations and transforms, written by component as they aren't plain values
+bool putSpaceValue(ByteWriter &out, const Any &value)
+{
+  if (value.is<quaternionf>()) {
+    const auto q = value.get<quaternionf>();
+    out.put(ValueType::QUATERNIONF);
+    out.put(vec4f(q.r, q.i, q.j, q.k));
+    return true;
+  }
+  if (value.is<linear2f>()) {
+    const auto l = value.get<linear2f>();
+    out.put(ValueType::LINEAR2F);
+    out.put(vec4f(l.vx.x, l.vx.y, l.vy.x, l.vy.y));
+    return true;
+  }
+  if (value.is<affine3f>()) {
+    const auto a = value.get<affine3f>();
+    out.put(ValueType::AFFINE3F);
+    out.put(a.l.vx);
+    out.put(a.l.vy);
+    out.put(a.l.vz);
+    out.put(a.p);
+    return true;
+  }
+  return false;
+}
+
+// False for types the cache doesn't hold
+bool putValue(ByteWriter &out, const Any &value)
+{
+  if (!value.valid()) {
+    out.put(ValueType::NONE);
+    return true;
+  }
+  if (value.is<bool>()) {
+    out.put(ValueType::BOOL);
+    out.put(uint8_t(value.get<bool>()));
+    return true;
+  }
+  if (value.is<std::string>()) {
+    out.put(ValueType::STRING);
+    out.put(value.get<std::string>());
+    return true;
+  }
+  return putValueAs<int>(out, value, ValueType::INT)
+      || putValueAs<uint8_t>(out, value, ValueType::UCHAR)
+      || putValueAs<uint32_t>(out, value, ValueType::UINT)
+      || putValueAs<float>(out, value, ValueType::FLOAT)
+      || putValueAs<vec2i>(out, value, ValueType::VEC2I)
+      || putValueAs<vec2f>(out, value, ValueType::VEC2F)
+      || putValueAs<vec3i>(out, value, ValueType::VEC3I)
+      || putValueAs<vec3f>(out, value, ValueType::VEC3F)
+      || putValueAs<vec4i>(out, value, ValueType::VEC4I)
+      || putValueAs<vec4f>(out, value, ValueType::VEC4F)
+      || putValueAs<range1f>(out, value, ValueType::RANGE1F)
+      || putSpaceValue(out, value);
+}
+
+Any getValue(ByteReader &in)
+{
+  switch (in.get<ValueType>()) {
+  case ValueType::NONE:
+    return Any();
+  case ValueType::BOOL:
+    return Any(in.get<uint8_t>() != 0);
+  case ValueType::INT:
+    return Any(in.get<int>());
+  case ValueType::UCHAR:
+    return Any(in.get<uint8_t>());
+  case ValueType::UINT:
+    return Any(in.get<uint32_t>());
+  case ValueType::FLOAT:
+    return Any(in.get<float>());
+  case ValueType::STRING:
+    return Any(in.getString());
+  case ValueType::VEC2I:
+    return Any(in.get<vec2i>());
+  case ValueType::VEC2F:
+    return Any(in.get<vec2f>());
+  case ValueType::VEC3I:
+    return Any(in.get<vec3i>());
+  case ValueType::VEC3F:
+    return Any(in.get<vec3f>());
+  case ValueType::VEC4I:
+    return Any(in.get<vec4i>());
+  case ValueType::VEC4F:
+    return Any(in.get<vec4f>());
+  case ValueType::RANGE1F:
+    return Any(in.get<range1f>());
+  case ValueType::QUATERNIONF: {
+    const auto q = in.get<vec4f>();
+    return Any(quaternionf(q.x, q.y, q.z, q.w));
+  }
+  case ValueType::LINEAR2F: {
+    const auto l = in.get<vec4f>();
+    return Any(linear2f(vec2f(l.x, l.y), vec2f(l.z, l.w)));
+  }
+  case ValueType::AFFINE3F: {
+    const auto vx = in.get<vec3f>();
+    const auto vy = in.get<vec3f>();
+    const auto vz = in.get<vec3f>();
+    const auto p = in.get<vec3f>();
+    return Any(affine3f(linear3f(vx, vy, vz), p));
+  }
+  default:
+    throw std::runtime_error("unknown value type");
+  }
+}
+
+// Key ////////////////////////////////////////////////////////////////////////
+
+struct SourceState
+{
+  uint64_t size{0};
+  int64_t mtime{0}; // in nanoseconds, where the platform has them
+  uint64_t contentHash{0};
+};
+
+// Bytes hashed at either end of the source, to tell apart a file rewritten
+// within the resolution of its modification time at the same size
+const size_t hashedBytes = 64 << 10;
+
+bool sourceState(const std::string &source, SourceState &state)
+{
+  struct stat info;
+  if (stat(source.c_str(), &info) != 0)
+    return false;
+  state.size = uint64_t(info.st_size);
+#if defined(__APPLE__)
+  state.mtime = int64_t(info.st_mtimespec.tv_sec) * 1000000000
+      + info.st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+  state.mtime = int64_t(info.st_mtime) * 1000000000;
+#else
+  state.mtime =
+      int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+
+  std::ifstream file(source, std::ios::binary);
+  std::vector<char> bytes(std::min<uint64_t>(state.size, 2 * hashedBytes));
+  const size_t head = std::min(bytes.size(), hashedBytes);
+  file.read(bytes.data(), head);
+  file.seekg(std::streamoff(state.size - (bytes.size() - head)));
+  file.read(bytes.data() + head, bytes.size() - head);
+  if (!file)
+    return false;
+
+  // FNV-1a
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (const char c : bytes)
+    h = (h ^ uint8_t(c)) * 0x100000001b3ull;
+  state.contentHash = h;
+  return true;
+}
+
+uint32_t importerVersion(const std::string &importer)
+{
+  auto version = importerVersions.find(importer);
+  return version == importerVersions.end() ? 0 : version->second;
+}
+
+// Reads the header and key, returns the settings of the cached import or
+// throws if it isn't current
+std::string readCurrentKey(
+    ByteReader &in, const std::string &source, const std::string &importer)
+{
+  const auto header = in.get<FileHeader>();
+  if (std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0
+      || header.formatVersion != formatVersion
+      || header.byteOrder != byteOrderMark)
+    throw std::runtime_error("not a scene cache of this version");
+
+  const auto cachedSource = in.getString();
+  const auto cachedImporter = in.getString();
+  auto settings = in.getString();
+  const auto cachedVersion = in.get<uint32_t>();
+  SourceState cached;
+  cached.size = in.get<uint64_t>();
+  cached.mtime = in.get<int64_t>();
+  cached.contentHash = in.get<uint64_t>();
+
+  SourceState current;
+  if (cachedSource != source || cachedImporter != importer
+      || cachedVersion != importerVersion(importer)
+      || !sourceState(source, current) || cached.size != current.size
+      || cached.mtime != current.mtime
+      || cached.contentHash != current.contentHash)
+    throw std::runtime_error("out of date");
+
+  return settings;
+}
+
+void makeDirectory(const std::string &directory)
+{
+#ifdef _WIN32
+  _mkdir(directory.c_str());
+#else
+  mkdir(directory.c_str(), 0755);
+#endif
+}
+
+// Writer /////////////////////////////////////////////////////////////////////
+
+// Writes the arrays of the subtree to 'file' as it goes, and its structure to
+// a buffer written at the end.  Each node gets an ID in the order it's
+// written, which references to it use.
+class SceneWriter
+{
+ public:
+  SceneWriter(std::ofstream &file) : file(file) {}
+
+  // False, with the reason in 'failure', for subtrees the cache can't hold
+  bool writeNode(const Node &node, const Node *parent);
+
+  ByteWriter structure;
+  std::string failure;
+
+ private:
+  bool writeData(const Data &data, const Node *parent);
+  bool writeTexture(const Node &node);
+  uint64_t writeArray(const HostArray &array, size_t itemBytes);
+  void align();
+
+  bool fail(const std::string &why)
+  {
+    failure = why;
+    return false;
+  }
+
+  std::ofstream &file;
+  std::unordered_map<const Node *, uint32_t> ids;
+};
+
+bool SceneWriter::writeNode(const Node &node, const Node *parent)
+{
+  auto id = ids.find(&node);
+  if (id != ids.end()) {
+    structure.put(Record::REFERENCE);
+    structure.put(id->second);
+    return true;
+  }
+  const uint32_t newId = ids.size();
+  ids[&node] = newId;
+
+  if (auto *data = dynamic_cast<const Data *>(&node))
+    return writeData(*data, parent);
+  if (node.type() == NodeType::TEXTURE)
+    return writeTexture(node);
+
+  switch (node.type()) {
+  case NodeType::GENERIC:
+  case NodeType::PARAMETER:
+  case NodeType::TRANSFORM:
+  case NodeType::MATERIAL:
+  case NodeType::VOLUME:
+  case NodeType::TRANSFER_FUNCTION:
+    break;
+  case NodeType::GEOMETRY: {
+    auto &geom = static_cast<const Geometry &>(node);
+    if (geom.skin || geom.weightsPerVertex)
+      return fail("skinned geometry '" + node.name() + "'");
+  } break;
+  default:
+    return fail(rkcommon::utility::lowerCase(NodeTypeToString[node.type()])
+        + " '" + node.name() + "'");
+  }
+
+  structure.put(Record::NODE);
+  structure.put(node.name());
+  structure.put(node.subType());
+  structure.put(node.description());
+  structure.put(uint8_t(node.type()));
+  structure.put(uint8_t((node.sgOnly() ? SG_ONLY : 0)
+      | (node.sgNoUI() ? SG_NO_UI : 0) | (node.readOnly() ? READ_ONLY : 0)));
+
+  // Only parameters and transforms hold values of their own, the others hold
+  // OSPRay handles
+  const bool hasValue =
+      node.type() == NodeType::PARAMETER || node.type() == NodeType::TRANSFORM;
+  if (!putValue(structure, hasValue ? node.value() : Any()))
+    return fail("value of '" + node.name() + "'");
+
+  structure.put(uint8_t(node.hasMinMax()));
+  if (node.hasMinMax()
+      && !(putValue(structure, node.min()) && putValue(structure, node.max())))
+    return fail("range of '" + node.name() + "'");
+
+  // Handles are recreated by the nodes which own them
+  std::vector<std::pair<std::string, const Node *>> children;
+  for (auto &c : node.children())
+    if (!(c.second->type() == NodeType::GENERIC && c.first == "handles"))
+      children.emplace_back(c.first, c.second.get());
+
+  structure.put(uint32_t(children.size()));
+  for (auto &c : children) {
+    structure.put(c.first);
+    if (!writeNode(*c.second, &node))
+      return false;
+  }
+
+  return true;
+}
+
+bool SceneWriter::writeData(const Data &data, const Node *parent)
+{
+  HostArray array;
+  if (auto *geom = dynamic_cast<const Geometry *>(parent))
+    array = dataArrayOf(*geom, data);
+  else if (auto *volume = dynamic_cast<const Volume *>(parent))
+    array = dataArrayOf(*volume, data);
+  else if (auto *tf = dynamic_cast<const TransferFunction *>(parent))
+    array = dataArrayOf(*tf, data);
+  else
+    return fail("data '" + data.name() + "' outside of a geometry or volume");
+
+  const auto itemBytes = itemBytesOf(data.format);
+  if (!array.data || !itemBytes || data.itemBytes != itemBytes)
+    return fail("data '" + data.name() + "' which isn't kept on the host");
+
+  structure.put(Record::DATA);
+  structure.put(uint8_t((data.sgOnly() ? SG_ONLY : 0)
+      | (data.sgNoUI() ? SG_NO_UI : 0) | (data.readOnly() ? READ_ONLY : 0)));
+  structure.put(uint32_t(data.format));
+  structure.put(uint64_t(data.numItems.x));
+  structure.put(uint64_t(data.numItems.y));
+  structure.put(uint64_t(data.numItems.z));
+  structure.put(writeArray(array, itemBytes));
+  return true;
+}
+
+bool SceneWriter::writeTexture(const Node &node)
+{
+  auto *tex = dynamic_cast<const Texture2D *>(&node);
+  if (!tex || !tex->texels())
+    return fail("texture '" + node.name() + "' which isn't loaded");
+
+  // Textures loaded from files are reloaded from them (or the texture cache).
+  // Those given to Texture2D::load() in memory, ie. decoded by tinygltf, keep
+  // their texels in the cache.  Both recreate their children on load.
+  const auto &params = tex->params;
+  if (!params.inMemory) {
+    if (tex->fileName.empty())
+      return fail("texture '" + node.name() + "' without a file");
+    structure.put(Record::TEXTURE);
+  } else
+    structure.put(Record::TEXELS);
+  structure.put(node.name());
+  structure.put(tex->fileName);
+  structure.put(uint8_t(params.preferLinear));
+  structure.put(uint8_t(params.nearestFilter));
+  structure.put(int32_t(params.colorChannel));
+  if (!params.inMemory) {
+    structure.put(uint8_t(params.flip));
+    return true;
+  }
+
+  const size_t numBytes =
+      params.size.product() * params.components * params.depth;
+  structure.put(uint64_t(params.size.x));
+  structure.put(uint64_t(params.size.y));
+  structure.put(int32_t(params.components));
+  structure.put(int32_t(params.depth));
+  structure.put(uint64_t(numBytes));
+  const HostArray texels{node.name(), tex->texels(), numBytes, numBytes};
+  structure.put(writeArray(texels, 1));
+  return true;
+}
+
+void SceneWriter::align()
+{
+  static const char zeros[arrayAlignment] = {};
+  const uint64_t offset = file.tellp();
+  file.write(
+      zeros, (arrayAlignment - offset % arrayAlignment) % arrayAlignment);
+}
+
+uint64_t SceneWriter::writeArray(const HostArray &array, size_t itemBytes)
+{
+  align();
+  const uint64_t offset = file.tellp();
+
+  auto *items = static_cast<const char *>(array.data);
+  if (!array.byteStride || array.byteStride == itemBytes) {
+    file.write(items, array.numItems * itemBytes);
+    return offset;
+  }
+
+  // Strided arrays are stored packed, a batch of items at a time
+  std::vector<char> packed;
+  const size_t batchItems = (1 << 20) / itemBytes + 1;
+  for (size_t first = 0; first < array.numItems; first += batchItems) {
+    const size_t n = std::min(batchItems, array.numItems - first);
+    packed.resize(n * itemBytes);
+    for (size_t i = 0; i < n; i++)
+      std::memcpy(&packed[i * itemBytes],
+          items + (first + i) * array.byteStride,
+          itemBytes);
+    file.write(packed.data(), packed.size());
+  }
+  return offset;
+}
+
+// Reader /////////////////////////////////////////////////////////////////////
+
+// Recreates the nodes written by SceneWriter, sharing the arrays straight from
+// the mapped file.  Material IDs are rebased by 'materialDelta' when the
+// registry holds a different number of materials than when the import was
+// cached.
+class SceneReader
+{
+ public:
+  SceneReader(std::shared_ptr<MappedFile> file,
+      ByteReader structure,
+      uint32_t materialDelta)
+      : file(file), in(structure), materialDelta(materialDelta)
+  {}
+
+  // Reads the next node.  Data nodes are added to 'parent' right away, the
+  // others are left to the caller.  Returns nullptr for textures which fail
+  // to load.
+  NodePtr readNode(Node *parent, const std::string &key, bool &added);
+
+ private:
+  NodePtr readData(Node *parent, const std::string &key);
+  NodePtr readTexture(bool inMemory);
+  const uint8_t *mappedArray(uint64_t offset, uint64_t numBytes) const;
+
+  std::shared_ptr<MappedFile> file;
+  ByteReader in;
+  uint32_t materialDelta{0};
+  std::vector<NodePtr> nodes; // by ID
+};
+
+NodePtr SceneReader::readNode(Node *parent, const std::string &key, bool &added)
+{
+  added = false;
+
+  const auto record = in.get<Record>();
+  if (record == Record::REFERENCE) {
+    const auto id = in.get<uint32_t>();
+    if (id >= nodes.size())
+      throw std::runtime_error("bad node reference");
+    return nodes[id];
+  }
+  if (record == Record::DATA) {
+    added = true;
+    return readData(parent, key);
+  }
+  if (record == Record::TEXTURE || record == Record::TEXELS)
+    return readTexture(record == Record::TEXELS);
+  if (record != Record::NODE)
+    throw std::runtime_error("unknown record");
+
+  const auto name = in.getString();
+  const auto subType = in.getString();
+  const auto description = in.getString();
+  const auto type = NodeType(in.get<uint8_t>());
+  const auto flags = in.get<uint8_t>();
+  const auto value = getValue(in);
+
+  auto node = value.valid() ? createNode(name, subType, description, value)
+                            : createNode(name, subType);
+  if (node->type() != type)
+    throw std::runtime_error("node '" + name + "' changed type");
+  nodes.push_back(node);
+
+  if (flags & SG_ONLY)
+    node->setSGOnly();
+  if (flags & SG_NO_UI)
+    node->setSGNoUI();
+  if (flags & READ_ONLY)
+    node->setReadOnly();
+  if (in.get<uint8_t>()) {
+    const auto min = getValue(in);
+    const auto max = getValue(in);
+    node->setMinMax(min, max);
+  }
+
+  // Keep the mapping while the geometry shares its arrays
+  if (type == NodeType::GEOMETRY)
+    node->nodeAs<Geometry>()->sharedMemoryOwners.push_back(file);
+
+  const auto numChildren = in.get<uint32_t>();
+  for (uint32_t i = 0; i < numChildren; i++) {
+    const auto childKey = in.getString();
+    bool childAdded = false;
+    auto child = readNode(node.get(), childKey, childAdded);
+    if (child && !childAdded)
+      node->add(child, childKey);
+  }
+
+  return node;
+}
+
+NodePtr SceneReader::readData(Node *parent, const std::string &key)
+{
+  const auto flags = in.get<uint8_t>();
+  const auto format = OSPDataType(in.get<uint32_t>());
+  vec3ul numItems;
+  numItems.x = in.get<uint64_t>();
+  numItems.y = in.get<uint64_t>();
+  numItems.z = in.get<uint64_t>();
+  const auto offset = in.get<uint64_t>();
+
+  const auto itemBytes = itemBytesOf(format);
+  if (!parent || !itemBytes)
+    throw std::runtime_error("bad data '" + key + "'");
+  const size_t n = numItems.long_product();
+  const void *items = mappedArray(offset, n * itemBytes);
+
+  std::shared_ptr<Data> data;
+  if (auto *geom = dynamic_cast<Geometry *>(parent)) {
+    if (key == "material" && format == OSP_UINT && materialDelta) {
+      auto *ids = static_cast<const uint32_t *>(items);
+      geom->mIDs.assign(ids, ids + n);
+      for (auto &id : geom->mIDs)
+        id += materialDelta;
+      data = std::make_shared<Data>(geom->mIDs, true);
+    } else
+      data = sharedData(format, numItems, items);
+  } else if (auto *volume = dynamic_cast<Volume *>(parent)) {
+    volume->voxels = std::shared_ptr<void>(file, const_cast<void *>(items));
+    data = sharedData(format, numItems, items);
+  } else if (auto *tf = dynamic_cast<TransferFunction *>(parent)) {
+    if (key == "color" && format == OSP_VEC3F) {
+      auto *colors = static_cast<const vec3f *>(items);
+      tf->colors.assign(colors, colors + n);
+      data = std::make_shared<Data>(tf->colors);
+    } else if (key == "opacity" && format == OSP_FLOAT) {
+      auto *opacities = static_cast<const float *>(items);
+      tf->opacities.assign(opacities, opacities + n);
+      data = std::make_shared<Data>(tf->opacities);
+    }
+  }
+  if (!data)
+    throw std::runtime_error("bad data '" + key + "'");
+
+  nodes.push_back(data);
+  parent->createChildData(key, data);
+
+  if (flags & SG_ONLY)
+    data->setSGOnly();
+  if (flags & SG_NO_UI)
+    data->setSGNoUI();
+  if (flags & READ_ONLY)
+    data->setReadOnly();
+
+  return data;
+}
+
+NodePtr SceneReader::readTexture(bool inMemory)
+{
+  const auto name = in.getString();
+  const auto fileName = in.getString();
+  const bool preferLinear = in.get<uint8_t>();
+  const bool nearestFilter = in.get<uint8_t>();
+  const auto colorChannel = in.get<int32_t>();
+
+  NodePtr node = createNode(name, "texture_2d");
+  auto &tex = *node->nodeAs<Texture2D>();
+  bool loaded = false;
+  if (!inMemory) {
+    tex.params.flip = in.get<uint8_t>();
+    loaded = tex.load(fileName, preferLinear, nearestFilter, colorChannel);
+  } else {
+    tex.params.size.x = in.get<uint64_t>();
+    tex.params.size.y = in.get<uint64_t>();
+    tex.params.components = in.get<int32_t>();
+    tex.params.depth = in.get<int32_t>();
+    const auto numBytes = in.get<uint64_t>();
+    const auto offset = in.get<uint64_t>();
+    if (numBytes
+        != tex.params.size.product() * tex.params.components
+            * tex.params.depth)
+      throw std::runtime_error("bad texture '" + name + "'");
+
+    // Shared straight from the mapping, like the data parameters
+    auto *texels = mappedArray(offset, numBytes);
+    loaded = tex.load(fileName,
+        preferLinear,
+        nearestFilter,
+        colorChannel,
+        nullptr,
+        std::shared_ptr<void>(file, const_cast<uint8_t *>(texels)));
+  }
+  if (!loaded)
+    node = nullptr;
+
+  nodes.push_back(node);
+  return node;
+}
+
+// The 'numBytes' at 'offset' of the file, throws if they aren't an array
+const uint8_t *SceneReader::mappedArray(
+    uint64_t offset, uint64_t numBytes) const
+{
+  if (offset % arrayAlignment || offset > file->size()
+      || numBytes > file->size() - offset)
+    throw std::runtime_error("bad array offset");
+  return file->data() + offset;
+}
+
+} // namespace
+
+// Scene cache definitions ////////////////////////////////////////////////////
+
+std::string sceneCacheFile(
+    const std::string &source, const std::string &importer)
+{
+  if (sceneCacheSettings.directory.empty() || !importerVersion(importer))
+    return "";
+
+  // FNV-1a, to tell apart files of the same name in different directories
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (const char c : source + '\n' + importer)
+    h = (h ^ uint8_t(c)) * 0x100000001b3ull;
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)h);
+
+  return sceneCacheSettings.directory + "/" + FileName(source).name() + "-"
+      + hash + ".sgcache";
+}
+
+bool sceneCacheIsCurrent(const std::string &cacheFile,
+    const std::string &source,
+    const std::string &importer)
+{
+  auto file = MappedFile::open(cacheFile);
+  if (!file)
+    return false;
+
+  try {
+    ByteReader in{file->data(), file->data() + file->size()};
+    readCurrentKey(in, source, importer);
+    return true;
+  } catch (const std::exception &) {
+    return false;
+  }
+}
+
+bool writeSceneCache(const std::string &cacheFile,
+    const SceneCacheKey &key,
+    const Node &root,
+    const MaterialRegistry &registry,
+    uint32_t firstMaterial)
+{
+  SourceState state;
+  const auto version = importerVersion(key.importer);
+  const uint32_t endMaterial = registry.baseMaterialOffSet();
+  if (!version || !sourceState(key.source, state)
+      || endMaterial < firstMaterial)
+    return false;
+
+  makeDirectory(sceneCacheSettings.directory);
+
+  // Written next to the cache file and renamed once complete, so a cache
+  // file is never seen half written
+  const std::string tmpFile = cacheFile + ".tmp";
+  std::ofstream file(tmpFile, std::ios::binary);
+  if (!file) {
+    std::cerr << "Could not create scene cache " << tmpFile << std::endl;
+    return false;
+  }
+
+  FileHeader header{};
+  std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+  header.formatVersion = formatVersion;
+  header.byteOrder = byteOrderMark;
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  ByteWriter keyBytes;
+  keyBytes.put(key.source);
+  keyBytes.put(key.importer);
+  keyBytes.put(key.settings);
+  keyBytes.put(version);
+  keyBytes.put(state.size);
+  keyBytes.put(state.mtime);
+  keyBytes.put(state.contentHash);
+  file.write(reinterpret_cast<const char *>(keyBytes.bytes.data()),
+      keyBytes.bytes.size());
+
+  // The materials of the import are the last ones in the registry
+  SceneWriter writer(file);
+  const uint32_t numMaterials = endMaterial - firstMaterial;
+  const auto &materials = registry.children();
+  writer.structure.put(firstMaterial);
+  writer.structure.put(numMaterials);
+  bool cached = true;
+  size_t i = 0;
+  for (auto &material : materials) {
+    if (i++ < materials.size() - numMaterials)
+      continue;
+    cached = writer.writeNode(*material.second, nullptr);
+    if (!cached)
+      break;
+  }
+  cached = cached && writer.writeNode(root, nullptr);
+
+  if (cached) {
+    header.structureOffset = file.tellp();
+    header.structureSize = writer.structure.bytes.size();
+    file.write(reinterpret_cast<const char *>(writer.structure.bytes.data()),
+        writer.structure.bytes.size());
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+  file.close();
+
+  if (!cached || file.fail()) {
+    std::remove(tmpFile.c_str());
+    if (!cached)
+      std::cout << "Not caching " << key.source << ", it has "
+                << writer.failure << std::endl;
+    else
+      std::cerr << "Could not write scene cache " << tmpFile << std::endl;
+    return false;
+  }
+
+  std::remove(cacheFile.c_str());
+  if (std::rename(tmpFile.c_str(), cacheFile.c_str()) != 0) {
+    std::remove(tmpFile.c_str());
+    return false;
+  }
+  return true;
+}
+
+NodePtr readSceneCache(const std::string &cacheFile,
+    const SceneCacheKey &key,
+    MaterialRegistry &registry)
+{
+  auto file = MappedFile::open(cacheFile);
+  if (!file)
+    return nullptr;
+
+  try {
+    ByteReader in{file->data(), file->data() + file->size()};
+    if (readCurrentKey(in, key.source, key.importer) != key.settings)
+      return nullptr;
+
+    const auto header = ByteReader{file->data(), in.end}.get<FileHeader>();
+    if (header.structureOffset > file->size()
+        || header.structureSize > file->size() - header.structureOffset)
+      throw std::runtime_error("truncated file");
+    ByteReader structure{file->data() + header.structureOffset,
+        file->data() + header.structureOffset + header.structureSize};
+
+    const auto firstMaterial = structure.get<uint32_t>();
+    const auto numMaterials = structure.get<uint32_t>();
+    SceneReader reader(
+        file, structure, registry.baseMaterialOffSet() - firstMaterial);
+
+    bool added = false;
+    std::vector<NodePtr> materials;
+    for (uint32_t i = 0; i < numMaterials; i++)
+      materials.push_back(reader.readNode(nullptr, "", added));
+    auto root = reader.readNode(nullptr, "", added);
+    if (!root)
+      throw std::runtime_error("no root node");
+
+    // Only now the import is known to be complete
+    for (auto &m : materials)
+      if (m)
+        registry.add(m);
+
+    return root;
+  } catch (const std::exception &e) {
+    std::cerr << "Ignoring scene cache " << cacheFile << ": " << e.what()
+              << std::endl;
+    return nullptr;
+  }
+}
+
+} // namespace sg
+} // namespace ospray
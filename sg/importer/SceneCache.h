@@ -0,0 +1,80 @@
+// Copyright 2022 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "sg/Node.h"
+// stl
+#include <cstdint>
+#include <string>
+
+namespace ospray {
+namespace sg {
+
+struct MaterialRegistry;
+
+// On-disk cache of imported subtrees.  An import is written to the cache in a
+// binary format once it is complete.  The next import of the same file, in
+// the same state and by the same version of its importer, maps the cache
+// instead of running the rest of the importer.  The geometry arrays are shared
+// with OSPRay straight from the mapping.  A file is in the same state if its
+// size, modification time and the hash of its first and last 64 KB match.
+//
+// The OBJ, glTF/GLB, PCD and raw volume importers are cached.  Their subtrees
+// of transforms, geometries, parameters, materials, textures, structured
+// volumes and transfer functions are written whole: textures loaded from files
+// are reloaded from them, the texels of the others (ie. decoded by tinygltf)
+// are mapped like the geometry arrays and the voxels of raw volumes.  Imports
+// which also create lights, cameras, animations or skins aren't cached, nor
+// are vdb and particle volumes, whose importers hand their data to OSPRay
+// without keeping a host array the cache could map.
+
+// Global scene cache settings ////////////////////////////////////////////////
+
+struct OSPSG_INTERFACE SceneCacheSettings
+{
+  // Directory of the cache files, imports aren't cached while empty
+  std::string directory;
+};
+
+extern OSPSG_INTERFACE SceneCacheSettings sceneCacheSettings;
+
+// What a cached import was created from
+struct OSPSG_INTERFACE SceneCacheKey
+{
+  std::string source; // canonical path of the imported file
+  std::string importer; // its importer's subtype
+  // the importer's settings which change the subtree, see
+  // Importer::sceneCacheKey()
+  std::string settings;
+};
+
+// Cache file of the imports of 'source' by 'importer', or an empty string if
+// caching is off or the importer isn't cached
+OSPSG_INTERFACE std::string sceneCacheFile(
+    const std::string &source, const std::string &importer);
+
+// Whether 'cacheFile' holds an import of the current state of 'source' by
+// the current version of 'importer'.  Only reads the file's header, the
+// settings are checked by readSceneCache().
+OSPSG_INTERFACE bool sceneCacheIsCurrent(const std::string &cacheFile,
+    const std::string &source,
+    const std::string &importer);
+
+// Writes the subtree 'root' and the materials 'registry' got from the import,
+// from 'firstMaterial' on.  Returns false, without leaving a file, for
+// subtrees the cache can't hold.
+OSPSG_INTERFACE bool writeSceneCache(const std::string &cacheFile,
+    const SceneCacheKey &key,
+    const Node &root,
+    const MaterialRegistry &registry,
+    uint32_t firstMaterial);
+
+// Maps 'cacheFile' and recreates the subtree it holds, adding its materials
+// to 'registry'.  Returns nullptr if the cache isn't valid for 'key'.
+OSPSG_INTERFACE NodePtr readSceneCache(const std::string &cacheFile,
+    const SceneCacheKey &key,
+    MaterialRegistry &registry);
+
+} // namespace sg
+} // namespace ospray
@@ -2,11 +2,22 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "Importer.h"
+#include "MappedFile.h"
 // tiny_gltf
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 #include "tiny_gltf.h"
+// json
+#include <json.hpp>
 // rkcommon
 #include "rkcommon/os/FileName.h"
+#include "rkcommon/tasking/parallel_for.h"
+// stl
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <sstream>
 
 #include "glTF/buffer_view.h"
 #include "glTF/gltf_types.h"
@@ -79,6 +90,7 @@ struct GLTFData
   std::vector<NodePtr> lightTemplates;
   std::string geomId{""};
   bool importCameras{false};
+  double textureSeconds{0.0}; // part of createMaterials()
  private:
   InstanceConfiguration ic;
   NodePtr currentImporter;
@@ -91,13 +103,23 @@ struct GLTFData
   std::shared_ptr<sg::MaterialRegistry> materialRegistry;
   std::vector<NodePtr> sceneNodes; // lookup table glTF:nodeID -> NodePtr
 
-  tinygltf::Model model;
+  // Geometries share buffers of the model with OSPRay, keeping it alive
+  std::shared_ptr<tinygltf::Model> sharedModel{
+      std::make_shared<tinygltf::Model>()};
+  tinygltf::Model &model{*sharedModel};
+  // .glb file, mapped, and its BIN chunk
+  std::shared_ptr<MappedFile> glb;
+  const uint8_t *glbBinary{nullptr};
+  size_t glbBinarySize{0};
 
   std::vector<NodePtr> ospMaterials;
 
   size_t baseMaterialOffset = 0; // set in createMaterials()
   int numIntelLights{0};
 
+  bool loadGLB(
+      tinygltf::TinyGLTF &context, std::string &err, std::string &warn);
+
   void loadKeyframeInput(int accessorID, std::vector<float> &kfInput);
 
   void loadKeyframeOutput(std::vector<vec3f> &ts,
@@ -110,8 +132,28 @@ struct GLTFData
 
   void applyNodeTransform(NodePtr, const tinygltf::Node &node);
 
-  NodePtr createOSPMesh(
+  std::shared_ptr<Geometry> createOSPMesh(
       const std::string &primBaseName, tinygltf::Primitive &primitive);
+  // Fills the geometry's arrays, without creating any nodes
+  void loadPrimitive(Geometry &geom,
+      tinygltf::Primitive &primitive,
+      std::ostream &warnings);
+  // Creates the geometry's parameters from its arrays, or sharing the
+  // accessors' buffers
+  void attachPrimitive(Geometry &geom, tinygltf::Primitive &primitive);
+
+  // Whether OSPRay can use the accessor in place, as 'numItems' items of
+  // its type.  Only for triangles, skinned positions are modified.
+  bool isShareable(const tinygltf::Primitive &primitive,
+      int accessor,
+      int type,
+      int componentType,
+      size_t numItems) const;
+  template <typename T>
+  void createSharedData(
+      Geometry &geom, const std::string &param, int accessor, size_t numItems);
+  const uint8_t *bufferData(int buffer) const;
+  size_t bufferSize(int buffer) const;
 
   NodePtr createOSPMaterial(const tinygltf::Material &material);
 
@@ -149,6 +191,59 @@ inline std::string pad(std::string string, char p = '0', int length = 4)
   return std::string(std::max(0, length - (int)string.length()), p) + string;
 }
 
+// BIN chunk of a .glb and its size, nullptr if there is none.  The header
+// is 12 bytes, then chunks of 4 bytes length, 4 bytes type and data, the
+// first one being JSON.
+inline const uint8_t *glbBinaryChunk(const MappedFile &glb, size_t &size)
+{
+  const auto chunkLength = [&](size_t offset) {
+    uint32_t length;
+    std::memcpy(&length, glb.data() + offset, sizeof(length));
+    return size_t(length);
+  };
+
+  const size_t binary = 12 + 8 + chunkLength(12);
+  if (binary + 8 > glb.size()
+      || std::memcmp(glb.data() + binary + 4, "BIN\0", 4) != 0
+      || binary + 8 + chunkLength(binary) > glb.size())
+    return nullptr;
+  size = chunkLength(binary);
+  return glb.data() + binary + 8;
+}
+
+// Images stored in the BIN chunk of a .glb, decoded from the mapping
+struct GLBImages
+{
+  const uint8_t *binary{nullptr};
+  // Byte range in the BIN chunk per image, empty if not stored there
+  std::vector<std::pair<size_t, size_t>> ranges;
+};
+
+inline bool loadGLBImage(tinygltf::Image *image,
+    const int index,
+    std::string *err,
+    std::string *warn,
+    int width,
+    int height,
+    const unsigned char *bytes,
+    int size,
+    void *userData)
+{
+  const auto &images = *static_cast<const GLBImages *>(userData);
+  if (size_t(index) < images.ranges.size() && images.ranges[index].second) {
+    bytes = images.binary + images.ranges[index].first;
+    size = int(images.ranges[index].second);
+  }
+  return tinygltf::LoadImageData(
+      image, index, err, warn, width, height, bytes, size, nullptr);
+}
+
+inline double secondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
 bool GLTFData::parseAsset()
 {
   INFO << "TinyGLTF loading: " << fileName << "\n";
@@ -160,8 +255,15 @@ bool GLTFData::parseAsset()
   const auto isASCII = (fileName.ext() == "gltf");
   if (isASCII)
     ret = context.LoadASCIIFromFile(&model, &err, &warn, fileName);
-  else
-    ret = context.LoadBinaryFromFile(&model, &err, &warn, fileName);
+  else {
+    // Mapped rather than read into memory, and the BIN chunk is used in
+    // place (see loadGLB())
+    glb = MappedFile::open(fileName);
+    if (glb)
+      ret = loadGLB(context, err, warn);
+    else
+      ret = context.LoadBinaryFromFile(&model, &err, &warn, fileName);
+  }
 
 #if defined(REPORT_TINYGLTF_WARNINGS)
   if (!warn.empty()) {
@@ -231,6 +333,141 @@ bool GLTFData::parseAsset()
   return ret;
 }
 
+// tinygltf copies the BIN chunk into its buffer, so it only gets the JSON
+// chunk, with the buffers stored in the BIN chunk cut down to a byte.  Their
+// data is then read from the mapping (see bufferData()), and images stored
+// there are decoded from it.
+bool GLTFData::loadGLB(
+    tinygltf::TinyGLTF &context, std::string &err, std::string &warn)
+{
+  const uint8_t *bytes = glb->data();
+  uint32_t jsonLength = 0;
+  if (glb->size() >= 20)
+    std::memcpy(&jsonLength, bytes + 12, sizeof(jsonLength));
+  if (glb->size() < 20 || std::memcmp(bytes, "glTF", 4) != 0
+      || std::memcmp(bytes + 16, "JSON", 4) != 0
+      || 20 + size_t(jsonLength) > glb->size()) {
+    err = "Invalid glTF binary.";
+    return false;
+  }
+
+  size_t binarySize = 0;
+  const uint8_t *binary = glbBinaryChunk(*glb, binarySize);
+
+  GLBImages images;
+  images.binary = binary;
+  // Images moved to a placeholder view, and their own view
+  std::vector<std::pair<size_t, size_t>> movedImages;
+  size_t placeholderBuffer = 0;
+  std::string text;
+
+  try {
+    glb->prefetchSequential(0, 20 + size_t(jsonLength));
+    auto json = nlohmann::json::parse(bytes + 20, bytes + 20 + jsonLength);
+    glb->adviseNormal();
+
+    std::vector<bool> inBinary;
+    auto buffers = json.find("buffers");
+    if (binary && buffers != json.end() && buffers->is_array()) {
+      for (auto &buffer : *buffers) {
+        const bool embedded = buffer.is_object() && !buffer.contains("uri");
+        if (embedded) {
+          if (buffer.value("byteLength", size_t(0)) > binarySize) {
+            err = "Invalid `byteLength' of the BIN chunk buffer.";
+            return false;
+          }
+          buffer["byteLength"] = 1;
+          placeholderBuffer = inBinary.size();
+        }
+        inBinary.push_back(embedded);
+      }
+    }
+
+    // tinygltf decodes images from their buffer, point those in the BIN
+    // chunk at a one byte view instead, and give the loader their range
+    auto views = json.find("bufferViews");
+    auto imgs = json.find("images");
+    if (views != json.end() && views->is_array() && imgs != json.end()
+        && imgs->is_array()) {
+      const size_t placeholder = views->size();
+      for (size_t i = 0; i < imgs->size(); i++) {
+        auto &img = (*imgs)[i];
+        if (!img.is_object() || !img.contains("bufferView"))
+          continue;
+        const size_t v = img["bufferView"].get<size_t>();
+        if (v >= placeholder)
+          continue;
+        auto &view = (*views)[v];
+        const size_t buffer = view.value("buffer", size_t(0));
+        if (buffer >= inBinary.size() || !inBinary[buffer])
+          continue;
+
+        const size_t offset = view.value("byteOffset", size_t(0));
+        const size_t length = view.value("byteLength", size_t(0));
+        if (offset + length > binarySize
+            || length > size_t(std::numeric_limits<int>::max())) {
+          err = "Invalid bufferView of image[" + std::to_string(i) + "].";
+          return false;
+        }
+        images.ranges.resize(i + 1);
+        images.ranges[i] = {offset, length};
+        img["bufferView"] = placeholder;
+        movedImages.emplace_back(i, v);
+      }
+      if (!movedImages.empty())
+        views->push_back({{"buffer", placeholderBuffer}, {"byteLength", 1}});
+    }
+
+    text = json.dump();
+  } catch (const std::exception &e) {
+    glb->adviseNormal();
+    err = std::string("Failed to parse the JSON chunk: ") + e.what();
+    return false;
+  }
+
+  // A .glb of the JSON chunk and a one byte BIN chunk
+  text.resize((text.size() + 3) & ~size_t(3), ' ');
+  std::vector<uint8_t> header;
+  const auto put = [&](const void *data, size_t size) {
+    const auto *begin = static_cast<const uint8_t *>(data);
+    header.insert(header.end(), begin, begin + size);
+  };
+  const auto putU32 = [&](uint32_t value) { put(&value, sizeof(value)); };
+  const size_t binaryChunk = binary ? 12 : 0;
+  put("glTF", 4);
+  putU32(2);
+  putU32(uint32_t(12 + 8 + text.size() + binaryChunk));
+  putU32(uint32_t(text.size()));
+  put("JSON", 4);
+  put(text.data(), text.size());
+  if (binary) {
+    putU32(4);
+    put("BIN\0", 4);
+    putU32(0);
+  }
+  std::string().swap(text);
+
+  context.SetImageLoader(loadGLBImage, &images);
+  if (!context.LoadBinaryFromMemory(&model,
+          &err,
+          &warn,
+          header.data(),
+          (unsigned int)header.size(),
+          fileName.path()))
+    return false;
+
+  for (auto &m : movedImages)
+    model.images[m.first].bufferView = int(m.second);
+  if (!movedImages.empty())
+    model.bufferViews.pop_back();
+
+  if (binary) {
+    glbBinary = binary;
+    glbBinarySize = binarySize;
+  }
+  return true;
+}
+
 void GLTFData::applySceneBackground(NodePtr bgXfm)
 {
   auto background = model.extensions.find("BIT_scene_background")->second;
@@ -418,6 +655,11 @@ void GLTFData::createMaterials()
   baseMaterialOffset = materialRegistry->baseMaterialOffSet();
   for (auto m : ospMaterials)
     materialRegistry->add(m);
+
+  // Textures copied the decoded images, release them before the model is
+  // kept alive by geometries sharing its buffers
+  for (auto &image : model.images)
+    std::vector<unsigned char>().swap(image.image);
 }
 
 void GLTFData::createCameraTemplates()
@@ -551,7 +793,7 @@ void GLTFData::createSkins()
     if (ibm.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT
         && ibm.type == TINYGLTF_TYPE_MAT4) {
       skins.emplace_back(new Skin);
-      Accessor<float[16]> m(ibm, model);
+      Accessor<float[16]> m(ibm, model, glbBinary);
       auto &xfm = skins.back()->inverseBindMatrices;
       xfm.reserve(m.size());
       for (size_t i = 0; i < m.size(); i++)
@@ -582,7 +824,25 @@ void GLTFData::createGeometries()
 {
   // DEBUG << "Create Geometries\n";
 
+  // Geometry nodes (and their OSPRay objects) are created serially, in
+  // order.  Their arrays are then filled from the accessors concurrently,
+  // which touches no nodes, and finally handed to the nodes serially again.
+  struct PrimitiveLoad
+  {
+    std::shared_ptr<Geometry> geom;
+    tinygltf::Primitive *prim;
+    std::ostringstream warnings;
+    std::exception_ptr error;
+  };
+  std::vector<PrimitiveLoad> loads;
+
+  size_t numPrimitives = 0;
+  for (auto &m : model.meshes)
+    numPrimitives += m.primitives.size();
+  loads.resize(numPrimitives);
+
   ospMeshes.reserve(model.meshes.size());
+  size_t p = 0;
   for (auto &m : model.meshes) {
     static auto nModel = 0;
     auto modelName = m.name + "_" + pad(std::to_string(nModel++));
@@ -593,9 +853,27 @@ void GLTFData::createGeometries()
       modelName = modelName + "_" + pad(std::to_string(nSubset++));
       auto mesh = createOSPMesh(modelName, prim);
       mesh_subsets.push_back(mesh);
+      loads[p].geom = mesh;
+      loads[p++].prim = &prim;
     }
     ospMeshes.push_back(mesh_subsets);
   }
+
+  tasking::parallel_for(loads.size(), [&](size_t i) {
+    auto &load = loads[i];
+    try {
+      loadPrimitive(*load.geom, *load.prim, load.warnings);
+    } catch (...) {
+      load.error = std::current_exception();
+    }
+  });
+
+  for (auto &load : loads) {
+    std::cout << load.warnings.str();
+    if (load.error)
+      std::rethrow_exception(load.error);
+    attachPrimitive(*load.geom, *load.prim);
+  }
 }
 
 // create animation channels and load sampler information
@@ -618,7 +896,7 @@ void GLTFData::createAnimations(std::vector<Animation> &animations)
       auto &valueAcc = model.accessors[s.output];
       if (c.target_path == "translation" || c.target_path == "scale") {
         // translation and scaling will always have complete dataType of vec3f
-        Accessor<vec3f> value(valueAcc, model);
+        Accessor<vec3f> value(valueAcc, model, glbBinary);
         auto *t = new AnimationTrack<vec3f>();
         track = t;
         t->values.reserve(value.size());
@@ -631,7 +909,7 @@ void GLTFData::createAnimations(std::vector<Animation> &animations)
               << std::endl;
           continue;
         }
-        Accessor<vec4f> value(valueAcc, model);
+        Accessor<vec4f> value(valueAcc, model, glbBinary);
         auto *t = new AnimationTrack<quaternionf>();
         track = t;
         t->values.reserve(value.size());
@@ -656,7 +934,7 @@ void GLTFData::createAnimations(std::vector<Animation> &animations)
       track->target =
           sceneNodes[c.target_node]->child(c.target_path).shared_from_this();
 
-      Accessor<float> time(inputAcc, model);
+      Accessor<float> time(inputAcc, model, glbBinary);
       track->times.reserve(time.size());
       for (size_t i = 0; i < time.size(); ++i)
         track->times.push_back(time[i]);
@@ -858,7 +1136,7 @@ void GLTFData::applyNodeTransform(NodePtr xfmNode, const tinygltf::Node &n)
   }
 }
 
-NodePtr GLTFData::createOSPMesh(
+std::shared_ptr<Geometry> GLTFData::createOSPMesh(
     const std::string &primBaseName, tinygltf::Primitive &prim)
 {
   static auto nPrim = 0;
@@ -887,16 +1165,33 @@ NodePtr GLTFData::createOSPMesh(
         "Unsupported primitive mode! Only triangles are supported");
   }
 
+  return ospGeom;
+}
+
+void GLTFData::loadPrimitive(
+    Geometry &geom, tinygltf::Primitive &prim, std::ostream &warnings)
+{
+  auto *ospGeom = &geom;
+  const auto vertices = model.accessors[prim.attributes["POSITION"]].count;
+
 #if 1 // XXX: Generalize these with full component support!!!
       // In : 1,2,3,4 ubyte, ubyte(N), ushort, ushort(N), uint, float
       // Out:   2,3,4 int, float
 
-  if (prim.indices > -1) {
+  // Arrays OSPRay can use in place are shared by attachPrimitive() instead
+  const bool shareIndices = prim.indices > -1
+      && isShareable(prim,
+          prim.indices,
+          TINYGLTF_TYPE_SCALAR,
+          TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT,
+          model.accessors[prim.indices].count / 3);
+  if (prim.indices > -1 && !shareIndices) {
     auto &vi = ospGeom->vi;
     // Indices: scalar ubyte/ushort/uint
     if (model.accessors[prim.indices].componentType
         == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-      Accessor<uint8_t> index_accessor(model.accessors[prim.indices], model);
+      Accessor<uint8_t> index_accessor(
+          model.accessors[prim.indices], model, glbBinary);
       vi.reserve(index_accessor.size() / 3);
       for (size_t i = 0; i < index_accessor.size() / 3; ++i)
         vi.emplace_back(vec3ui(index_accessor[i * 3],
@@ -904,7 +1199,8 @@ NodePtr GLTFData::createOSPMesh(
             index_accessor[i * 3 + 2]));
     } else if (model.accessors[prim.indices].componentType
         == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-      Accessor<uint16_t> index_accessor(model.accessors[prim.indices], model);
+      Accessor<uint16_t> index_accessor(
+          model.accessors[prim.indices], model, glbBinary);
       vi.reserve(index_accessor.size() / 3);
       for (size_t i = 0; i < index_accessor.size() / 3; ++i)
         vi.emplace_back(vec3ui(index_accessor[i * 3],
@@ -912,15 +1208,16 @@ NodePtr GLTFData::createOSPMesh(
             index_accessor[i * 3 + 2]));
     } else if (model.accessors[prim.indices].componentType
         == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
-      Accessor<uint32_t> index_accessor(model.accessors[prim.indices], model);
+      Accessor<uint32_t> index_accessor(
+          model.accessors[prim.indices], model, glbBinary);
       vi.reserve(index_accessor.size() / 3);
       for (size_t i = 0; i < index_accessor.size() / 3; ++i)
         vi.emplace_back(vec3ui(index_accessor[i * 3],
             index_accessor[i * 3 + 1],
             index_accessor[i * 3 + 2]));
     } else {
-      ERR << "Unsupported index type: "
-            << model.accessors[prim.indices].componentType << "\n";
+      warnings << prefix << "(E): Unsupported index type: "
+               << model.accessors[prim.indices].componentType << "\n";
       throw std::runtime_error("Unsupported index component type");
     }
   }
@@ -933,7 +1230,8 @@ NodePtr GLTFData::createOSPMesh(
     auto col_attrib = fnd->second;
     if (model.accessors[col_attrib].componentType
         == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-      Accessor<uint16_t> col_accessor(model.accessors[col_attrib], model);
+      Accessor<uint16_t> col_accessor(
+          model.accessors[col_attrib], model, glbBinary);
       vc.reserve(col_accessor.size() / 3);
       for (size_t i = 0; i < col_accessor.size() / 3; ++i)
         vc.emplace_back(vec4f(col_accessor[i * 3],
@@ -942,7 +1240,8 @@ NodePtr GLTFData::createOSPMesh(
             1.f));
     } else if (model.accessors[col_attrib].componentType
         == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-      Accessor<uint8_t> col_accessor(model.accessors[col_attrib], model);
+      Accessor<uint8_t> col_accessor(
+          model.accessors[col_attrib], model, glbBinary);
       vc.reserve(col_accessor.size() / 3);
       for (size_t i = 0; i < col_accessor.size() / 3; ++i)
         vc.emplace_back(vec4f(col_accessor[i * 3],
@@ -951,13 +1250,14 @@ NodePtr GLTFData::createOSPMesh(
             1.f));
     } else if (model.accessors[col_attrib].componentType
         == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-      Accessor<vec4f> col_accessor(model.accessors[col_attrib], model);
+      Accessor<vec4f> col_accessor(
+          model.accessors[col_attrib], model, glbBinary);
       vc.reserve(col_accessor.size());
       for (size_t i = 0; i < col_accessor.size(); ++i)
         vc.emplace_back(col_accessor[i]);
     } else {
-      ERR << "Unsupported color type: "
-            << model.accessors[col_attrib].componentType << "\n";
+      warnings << prefix << "(E): Unsupported color type: "
+               << model.accessors[col_attrib].componentType << "\n";
       throw std::runtime_error("Unsupported color component type");
     }
 
@@ -977,9 +1277,14 @@ NodePtr GLTFData::createOSPMesh(
   // Note: GLTF can have texture coordinates [0,1] used by different
   // textures.  Only supporting TEXCOORD_0
   fnd = prim.attributes.find("TEXCOORD_0");
-  if (fnd != prim.attributes.end()) {
+  if (fnd != prim.attributes.end()
+      && !isShareable(prim,
+          fnd->second,
+          TINYGLTF_TYPE_VEC2,
+          TINYGLTF_COMPONENT_TYPE_FLOAT,
+          vertices)) {
     auto &vt = ospGeom->vt;
-    Accessor<vec2f> uv_accessor(model.accessors[fnd->second], model);
+    Accessor<vec2f> uv_accessor(model.accessors[fnd->second], model, glbBinary);
     vt.reserve(uv_accessor.size());
     for (size_t i = 0; i < uv_accessor.size(); ++i)
       vt.emplace_back(uv_accessor[i]);
@@ -994,42 +1299,38 @@ NodePtr GLTFData::createOSPMesh(
 #endif
 #endif
 
-  // Add attribute arrays to mesh
-  if (ospGeom->subType() == "geometry_triangles") {
-    // Positions: vec3f
+  // Positions: vec3f
+  if (!isShareable(prim,
+          prim.attributes["POSITION"],
+          TINYGLTF_TYPE_VEC3,
+          TINYGLTF_COMPONENT_TYPE_FLOAT,
+          vertices)) {
     Accessor<vec3f> pos_accessor(
-        model.accessors[prim.attributes["POSITION"]], model);
-    const auto vertices = pos_accessor.size();
+        model.accessors[prim.attributes["POSITION"]], model, glbBinary);
     ospGeom->skinnedPositions.reserve(vertices);
     for (size_t i = 0; i < vertices; ++i)
       ospGeom->skinnedPositions.emplace_back(pos_accessor[i]);
-    ospGeom->createChildData(
-        "vertex.position", ospGeom->skinnedPositions, true);
+  }
 
+  if (ospGeom->subType() == "geometry_triangles") {
     // Normals: vec3f
     fnd = prim.attributes.find("NORMAL");
-    if (fnd != prim.attributes.end()) {
-      Accessor<vec3f> normal_accessor(model.accessors[fnd->second], model);
+    if (fnd != prim.attributes.end()
+        && !isShareable(prim,
+            fnd->second,
+            TINYGLTF_TYPE_VEC3,
+            TINYGLTF_COMPONENT_TYPE_FLOAT,
+            vertices)) {
+      Accessor<vec3f> normal_accessor(
+          model.accessors[fnd->second], model, glbBinary);
       if (vertices == normal_accessor.size()) {
         ospGeom->skinnedNormals.reserve(vertices);
         for (size_t i = 0; i < vertices; ++i)
           ospGeom->skinnedNormals.emplace_back(normal_accessor[i]);
-        ospGeom->createChildData(
-            "vertex.normal", ospGeom->skinnedNormals, true);
       } else
-        WARN << "mismatching NORMAL size\n";
+        warnings << prefix << "(W): mismatching NORMAL size\n";
     }
 
-    ospGeom->createChildData("index", ospGeom->vi, true);
-    if (vertices == ospGeom->vc.size())
-      ospGeom->createChildData("vertex.color", ospGeom->vc, true);
-    else if (!ospGeom->vc.empty())
-      WARN << "mismatching COLOR_0 size\n";
-    if (vertices == ospGeom->vt.size())
-      ospGeom->createChildData("vertex.texcoord", ospGeom->vt, true);
-    else if (!ospGeom->vt.empty())
-      WARN << "mismatching TEXCOORD_0 size\n";
-
     // skinning, XXX for now only for triangles
     ospGeom->weightsPerVertex = 0;
     int stride = 0;
@@ -1048,60 +1349,114 @@ NodePtr GLTFData::createOSPMesh(
       }
       auto &joints = model.accessors[fndj->second];
       if (vertices != joints.count) {
-        WARN << "mismatching JOINTS_" << set << " size\n";
+        warnings << prefix << "(W): mismatching JOINTS_" << set << " size\n";
         continue;
       }
       vec4us *geomJoints = (vec4us *)ospGeom->joints.data() + set;
       bool isVec4 = joints.type == TINYGLTF_TYPE_VEC4;
       if (isVec4
           && joints.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-        Accessor<vec4uc> joint(joints, model);
+        Accessor<vec4uc> joint(joints, model, glbBinary);
         for (size_t i = 0; i < joint.size(); ++i)
           geomJoints[i * stride] = joint[i];
       } else if (isVec4
           && joints.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-        Accessor<vec4us> joint(joints, model);
+        Accessor<vec4us> joint(joints, model, glbBinary);
         for (size_t i = 0; i < joint.size(); ++i)
           geomJoints[i * stride] = joint[i];
       } else
-        WARN << "invalid JOINTS_" << set << std::endl;
+        warnings << prefix << "(W): invalid JOINTS_" << set << "\n";
 
       auto &weights = model.accessors[fndw->second];
       if (vertices != weights.count) {
-        WARN << "mismatching WEIGHTS_" << set << " size\n";
+        warnings << prefix << "(W): mismatching WEIGHTS_" << set << " size\n";
         continue;
       }
       vec4f *geomWeights = (vec4f *)ospGeom->weights.data() + set;
       isVec4 = weights.type == TINYGLTF_TYPE_VEC4;
       if (isVec4
           && weights.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-        Accessor<vec4uc> weight(weights, model);
+        Accessor<vec4uc> weight(weights, model, glbBinary);
         for (size_t i = 0; i < weight.size(); ++i)
           geomWeights[i * stride] = weight[i] / 255.0f;
       } else if (isVec4
           && weights.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-        Accessor<vec4us> weight(weights, model);
+        Accessor<vec4us> weight(weights, model, glbBinary);
         for (size_t i = 0; i < weight.size(); ++i)
           geomWeights[i * stride] = weight[i] / 65535.0f;
       } else if (isVec4
           && weights.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-        Accessor<vec4f> weight(weights, model);
+        Accessor<vec4f> weight(weights, model, glbBinary);
         for (size_t i = 0; i < weight.size(); ++i)
           geomWeights[i * stride] = weight[i];
       } else
-        WARN << "invalid WEIGHTS_" << set << std::endl;
+        warnings << prefix << "(W): invalid WEIGHTS_" << set << "\n";
     }
 
     if (ospGeom->checkAndNormalizeWeights())
-      WARN << "non-normalized weights\n";
+      warnings << prefix << "(W): non-normalized weights\n";
+  }
+
+  // add one for default, "no material" material
+  auto materialID = prim.material + 1 + baseMaterialOffset;
+  ospGeom->mIDs.resize(vertices, materialID);
+}
+
+void GLTFData::attachPrimitive(Geometry &geom, tinygltf::Primitive &prim)
+{
+  auto *ospGeom = &geom;
+
+  // Add attribute arrays to mesh
+  if (ospGeom->subType() == "geometry_triangles") {
+    const int position = prim.attributes["POSITION"];
+    const auto vertices = model.accessors[position].count;
+    auto shareable = [&](int accessor, int type, size_t numItems) {
+      return isShareable(
+          prim, accessor, type, TINYGLTF_COMPONENT_TYPE_FLOAT, numItems);
+    };
+
+    if (shareable(position, TINYGLTF_TYPE_VEC3, vertices))
+      createSharedData<vec3f>(geom, "vertex.position", position, vertices);
+    else
+      ospGeom->createChildData(
+          "vertex.position", ospGeom->skinnedPositions, true);
+
+    auto fnd = prim.attributes.find("NORMAL");
+    if (fnd != prim.attributes.end()
+        && shareable(fnd->second, TINYGLTF_TYPE_VEC3, vertices))
+      createSharedData<vec3f>(geom, "vertex.normal", fnd->second, vertices);
+    else if (!ospGeom->skinnedNormals.empty())
+      ospGeom->createChildData(
+          "vertex.normal", ospGeom->skinnedNormals, true);
+
+    if (prim.indices > -1
+        && isShareable(prim,
+            prim.indices,
+            TINYGLTF_TYPE_SCALAR,
+            TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT,
+            model.accessors[prim.indices].count / 3))
+      createSharedData<vec3ui>(geom,
+          "index",
+          prim.indices,
+          model.accessors[prim.indices].count / 3);
+    else
+      ospGeom->createChildData("index", ospGeom->vi, true);
+
+    if (vertices == ospGeom->vc.size())
+      ospGeom->createChildData("vertex.color", ospGeom->vc, true);
+    else if (!ospGeom->vc.empty())
+      WARN << "mismatching COLOR_0 size\n";
+
+    fnd = prim.attributes.find("TEXCOORD_0");
+    if (vertices == ospGeom->vt.size())
+      ospGeom->createChildData("vertex.texcoord", ospGeom->vt, true);
+    else if (!ospGeom->vt.empty())
+      WARN << "mismatching TEXCOORD_0 size\n";
+    else if (fnd != prim.attributes.end()
+        && shareable(fnd->second, TINYGLTF_TYPE_VEC2, vertices))
+      createSharedData<vec2f>(geom, "vertex.texcoord", fnd->second, vertices);
 
   } else if (ospGeom->subType() == "geometry_spheres") {
-    // Positions: vec3f
-    Accessor<vec3f> pos_accessor(
-        model.accessors[prim.attributes["POSITION"]], model);
-    ospGeom->skinnedPositions.reserve(pos_accessor.size());
-    for (size_t i = 0; i < pos_accessor.size(); ++i)
-      ospGeom->skinnedPositions.emplace_back(pos_accessor[i]);
     ospGeom->createChildData(
         "sphere.position", ospGeom->skinnedPositions, true);
 
@@ -1118,15 +1473,85 @@ NodePtr GLTFData::createOSPMesh(
       ospGeom->createChildData("sphere.texcoord", ospGeom->vt, true);
   }
 
-  if (ospGeom) {
-    // add one for default, "no material" material
-    auto materialID = prim.material + 1 + baseMaterialOffset;
-    ospGeom->mIDs.resize(ospGeom->skinnedPositions.size(), materialID);
-    ospGeom->createChildData("material", ospGeom->mIDs, true);
-    ospGeom->child("material").setSGOnly();
-  }
+  ospGeom->createChildData("material", ospGeom->mIDs, true);
+  ospGeom->child("material").setSGOnly();
+}
 
-  return ospGeom;
+bool GLTFData::isShareable(const tinygltf::Primitive &prim,
+    int accessorID,
+    int type,
+    int componentType,
+    size_t numItems) const
+{
+  if (prim.mode != TINYGLTF_MODE_TRIANGLES || accessorID < 0)
+    return false;
+  for (auto &a : prim.attributes)
+    if (a.first.compare(0, 7, "JOINTS_") == 0)
+      return false;
+
+  auto &accessor = model.accessors[accessorID];
+  if (accessor.type != type || accessor.componentType != componentType
+      || accessor.normalized || accessor.sparse.isSparse
+      || accessor.bufferView < 0 || !numItems)
+    return false;
+
+  // Items of a shared array are vectors of the accessor's scalars (ie.
+  // triangles of 3 indices), which must be packed
+  if (type != TINYGLTF_TYPE_SCALAR && accessor.count != numItems)
+    return false;
+  auto &view = model.bufferViews[accessor.bufferView];
+  const size_t elementBytes = gltf_base_stride(type, componentType);
+  const size_t elements = accessor.count / numItems;
+  if (elements * numItems != accessor.count
+      || (elements > 1 && view.byteStride && view.byteStride != elementBytes))
+    return false;
+
+  const size_t itemBytes = elementBytes * elements;
+  const size_t stride = std::max(view.byteStride, itemBytes);
+  const size_t begin = view.byteOffset + accessor.byteOffset;
+  return begin + (numItems - 1) * stride + itemBytes
+      <= bufferSize(view.buffer)
+      && accessor.byteOffset + (numItems - 1) * stride + itemBytes
+      <= view.byteLength
+      && uintptr_t(bufferData(view.buffer) + begin) % sizeof(float) == 0
+      && stride % sizeof(float) == 0;
+}
+
+template <typename T>
+void GLTFData::createSharedData(
+    Geometry &geom, const std::string &param, int accessorID, size_t numItems)
+{
+  auto &accessor = model.accessors[accessorID];
+  auto &view = model.bufferViews[accessor.bufferView];
+  const uint8_t *data =
+      bufferData(view.buffer) + view.byteOffset + accessor.byteOffset;
+  const size_t byteStride = view.byteStride > sizeof(T) ? view.byteStride : 0;
+
+  geom.createChildData(param,
+      std::make_shared<Data>(numItems, byteStride, (const T *)data, true));
+
+  // A primitive may mix buffers of the BIN chunk with external ones
+  std::shared_ptr<const void> owner = sharedModel;
+  if (glbBinary && model.buffers[view.buffer].uri.empty())
+    owner = glb;
+  auto &owners = geom.sharedMemoryOwners;
+  if (std::find(owners.begin(), owners.end(), owner) == owners.end())
+    owners.push_back(owner);
+}
+
+const uint8_t *GLTFData::bufferData(int buffer) const
+{
+  // The buffer of a .glb without uri is its BIN chunk
+  if (glbBinary && model.buffers[buffer].uri.empty())
+    return glbBinary;
+  return model.buffers[buffer].data.data();
+}
+
+size_t GLTFData::bufferSize(int buffer) const
+{
+  if (glbBinary && model.buffers[buffer].uri.empty())
+    return glbBinarySize;
+  return model.buffers[buffer].data.size();
 }
 
 NodePtr GLTFData::createOSPMaterial(const tinygltf::Material &mat)
@@ -1749,8 +2174,10 @@ void GLTFData::setOSPTexture(NodePtr ospMat,
     return;
 
   auto texParam = "map_" + texParamBase;
+  const auto start = std::chrono::steady_clock::now();
   auto ospTexNode = createOSPTexture(
       texParam, model.textures[texIndex], colorChannel, preferLinear);
+  textureSeconds += secondsSince(start);
   if (ospTexNode) {
     auto &ospTex = *ospTexNode->nodeAs<Texture2D>();
     // DEBUG << pad("", '.', 3) << "        .setChild: " << texParam << "= "
@@ -1833,6 +2260,8 @@ void glTFImporter::importScene()
   // the import hierarchy
   std::string baseName = fileName.name() + "_rootXfm";
   auto rootNode = createNode(baseName, "transform");
+  if (startSceneCache())
+    return;
 
   GLTFData gltf(rootNode,
       fileName,
@@ -1842,19 +2271,33 @@ void glTFImporter::importScene()
       shared_from_this(),
       ic);
 
+  // Duration of each import stage, logged once done
+  auto start = std::chrono::steady_clock::now();
+  auto stageSeconds = [&]() {
+    const double seconds = secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    return seconds;
+  };
+
   if (!gltf.parseAsset())
     return;
+  const double parseSeconds = stageSeconds();
 
   gltf.createMaterials();
+  const double materialSeconds = stageSeconds() - gltf.textureSeconds;
+
   gltf.createLightTemplates();
 
   if (importCameras) {
     gltf.importCameras = true;
     gltf.createCameraTemplates();
   }
+  double sceneSeconds = stageSeconds();
 
   gltf.createSkins();
   gltf.createGeometries(); // needs skins
+  const double geometrySeconds = stageSeconds();
+
   gltf.buildScene();
   gltf.finalizeSkins(); // needs nodes / buildScene
   if (animations)
@@ -1866,9 +2309,18 @@ void glTFImporter::importScene()
     lightsMan->addGroupLights(gltf.lights);
   }
 
+  if (deduplicateGeometry)
+    deduplicateGeometries(*rootNode);
+
   // Finally, add node hierarchy to importer parent
   add(rootNode);
+  sceneSeconds += stageSeconds();
+  finishSceneCache(*rootNode);
 
+  INFO << "import times (s): parse " << parseSeconds << ", materials "
+       << materialSeconds << ", textures " << gltf.textureSeconds
+       << ", geometry " << geometrySeconds << ", scene build " << sceneSeconds
+       << "\n";
   INFO << "finished import!\n";
 }
 
@@ -15,7 +15,12 @@ struct BufferView {
     size_t length = 0;
     size_t stride = 0;
 
-    BufferView(const tinygltf::BufferView &view, const tinygltf::Model &model, size_t base_stride);
+    // 'binary' is the data of a .glb's buffer without uri (its BIN chunk),
+    // when not loaded into the model
+    BufferView(const tinygltf::BufferView &view,
+        const tinygltf::Model &model,
+        size_t base_stride,
+        const uint8_t *binary = nullptr);
 
     BufferView() = default;
 
@@ -29,7 +34,9 @@ class Accessor {
     size_t count = 0;
 
 public:
-    Accessor(const tinygltf::Accessor &accessor, const tinygltf::Model &model);
+    Accessor(const tinygltf::Accessor &accessor,
+        const tinygltf::Model &model,
+        const uint8_t *binary = nullptr);
 
     Accessor() = default;
 
@@ -44,8 +51,12 @@ public:
 
 BufferView::BufferView(const tinygltf::BufferView &view,
     const tinygltf::Model &model,
-    size_t base_stride)
-    : buf(model.buffers[view.buffer].data.data() + view.byteOffset),
+    size_t base_stride,
+    const uint8_t *binary)
+    : buf((binary && model.buffers[view.buffer].uri.empty()
+                  ? binary
+                  : model.buffers[view.buffer].data.data())
+          + view.byteOffset),
       length(view.byteLength),
       stride(std::max(view.byteStride, base_stride))
 {}
@@ -56,10 +67,13 @@ inline const uint8_t *BufferView::operator[](const size_t i) const
 }
 
 template <typename T>
-Accessor<T>::Accessor(const tinygltf::Accessor &accessor, const tinygltf::Model &model)
+Accessor<T>::Accessor(const tinygltf::Accessor &accessor,
+    const tinygltf::Model &model,
+    const uint8_t *binary)
     : view(model.bufferViews[accessor.bufferView],
            model,
-           gltf_base_stride(accessor.type, accessor.componentType)),
+           gltf_base_stride(accessor.type, accessor.componentType),
+           binary),
       count(accessor.count)
 {
     // Apply the additional accessor-specific byte offset
@@ -26,6 +26,9 @@ void RawImporter::importScene()
 {
   using namespace std::string_literals;
 
+  if (startSceneCache())
+    return;
+
   // Keep this object alive for the duration of any lambdas
   auto self = shared_from_this();
 
@@ -50,30 +53,11 @@ void RawImporter::importScene()
       volume = createNode(nodeName, "structuredRegular");
     }
 
-    for (auto &c : volumeParams->children()) {
-      // Need to make a copy of the volume parameter here. If multiple threads
-      // are using the same VolumeParams children objects, then because of the
-      // book keeping involved with a node remembering its parents, multiple
-      // threads could modify the parents vector within a Node object.
-      //
-      // Example: Threads "foo" and "bar" are running at the same time.
-      // First, Foo adds a VolumeParams child to its own Volume object. Foo
-      // recognizes that it will need to resize the Node::properties::parents
-      // vector. Foo allocates a new parents vector. Next, Bar follows the
-      // same process and allocates a new parents vector. Foo deallocates the
-      // old pointer and so does Bar, leading to a double-free.
-      //
-      // The actual reason this happens is because although the
-      // Importer::volumeParams object is newly created each time
-      // Importer::getImporter() is called, the children of each of the
-      // separate Importer::volumeParams objects are all references to the
-      // exact same Node object.
-
-      // Preferably this code would be something like:
-      //   volume->add(createNodeLike(c.second))
-      auto &p = c.second;
-      volume->createChild(p->name(), p->subType(), p->description(), p->value());
-    }
+    // The children of every Importer::volumeParams are the very same nodes
+    // (see Importer::getImporter()), so concurrent import tasks share them.
+    // Node linking is thread safe, no need to copy them anymore.
+    for (auto &c : volumeParams->children())
+      volume->add(c.second);
 
     if (isSpherical) {
       auto sphericalVolume =
@@ -90,6 +74,9 @@ void RawImporter::importScene()
     volume->add(tf);
 
     rootNode->add(volume);
+    // Written here, as the volume is complete, rather than on the OSPRay
+    // thread
+    finishSceneCache(*rootNode);
 
     auto name = "add raw volume from "s + fileName.str() + " to scene"s;
     scheduler->ospray()->push(name, [&, self, rootNode](SchedulerPtr scheduler) {
@@ -20,7 +20,7 @@ struct OSPSG_INTERFACE MaterialRegistry : public Node
 
   void updateRendererType();
 
-  inline uint32_t baseMaterialOffSet()
+  inline uint32_t baseMaterialOffSet() const
   {
     return children().size() - nonMaterialCount;
   }
@@ -25,6 +25,14 @@ Transform::Transform()
       false);
 }
 
+Transform::~Transform()
+{
+  if (auto ids = pickIds.lock()) {
+    ids->release(sgInstId);
+    ids->release(sgGeomId);
+  }
+}
+
 NodeType Transform::type() const
 {
   return NodeType::TRANSFORM;
@@ -11,7 +11,7 @@ namespace sg {
 struct OSPSG_INTERFACE Transform : public Node_T<affine3f>
 {
   Transform();
-  ~Transform() override = default;
+  ~Transform() override;
 
   NodeType type() const override;
 
@@ -20,6 +20,12 @@ struct OSPSG_INTERFACE Transform : public Node_T<affine3f>
   affine3f accumulatedXfm{one};
   affine3f accumulatedEndXfm{one};
   bool motionBlur{false}; // accumulatedEndXfm is different
+
+  // SG ids for picking, given out by the world the first time RenderScene
+  // reaches the node, and returned to it when the node is destroyed
+  unsigned int sgInstId{0};
+  unsigned int sgGeomId{0};
+  std::weak_ptr<PickIdAllocator> pickIds;
 };
 
 } // namespace sg
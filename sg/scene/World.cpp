@@ -24,13 +24,20 @@ World::World()
 
   instSGIdMap = std::make_shared<OSPInstanceSGIdMap>();
   geomSGIdMap = std::make_shared<OSPGeomModelSGIdMap>();
+  instanceCache = std::make_shared<InstanceCache>();
+  pickIds = std::make_shared<PickIdAllocator>();
 }
 
 void World::preCommit()
 {
-  for (auto &c : children())
-    if (c.second->type() == NodeType::PARAMETER)
-      c.second->setOSPRayParam(c.first, valueAs<cpp::World>().handle());
+  // Taken before committing the children, which clears the list.  Only these
+  // need updating, by RenderScene and here.
+  auto &changed = instanceCache->changed;
+  changed       = modifiedChildren();
+
+  for (auto *c : changed)
+    if (c->type() == NodeType::PARAMETER)
+      c->setOSPRayParam(c->name(), valueAs<cpp::World>().handle());
 }
 
 void World::postCommit()
@@ -38,6 +45,28 @@ void World::postCommit()
   traverse<RenderScene>();
 }
 
+ScenePick World::resolvePick(const cpp::PickResult &result) const
+{
+  ScenePick pick;
+  if (!result.hasHit)
+    return pick;
+
+  pick.hasHit = true;
+  pick.worldPosition = vec3f(result.worldPosition);
+  pick.primID = result.primID;
+
+  if (auto *id = instSGIdMap->find(result.instance.handle())) {
+    pick.instance = id->node.lock();
+    pick.sgInstId = id->sgId;
+  }
+  if (auto *id = geomSGIdMap->find(result.model.handle())) {
+    pick.geometry = id->node.lock();
+    pick.sgGeomId = id->sgId;
+  }
+
+  return pick;
+}
+
 OSP_REGISTER_SG_NODE_NAME(World, world);
 
 } // namespace sg
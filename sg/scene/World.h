@@ -8,6 +8,48 @@
 namespace ospray {
 namespace sg {
 
+// The OSPRay instances RenderScene placed in a world, kept across commits so
+// that edits only update the instances they affect
+struct OSPSG_INTERFACE InstanceCache
+{
+  struct Entry
+  {
+    cpp::Group group;
+    cpp::Instance instance;
+    size_t slot; // index in 'instances'
+  };
+
+  // Keyed by Node::uniqueID(), unlike addresses not reused by later nodes.
+  // Per Transform (or grouped Light) node, in traversal order
+  std::unordered_map<size_t, std::vector<Entry>> entries;
+  // Geometric model registered for picking, per Geometry node
+  std::unordered_map<size_t, OSPGeometricModel> models;
+  // Hash of the children of each Transform node, which tells a transform
+  // given a new value from one which got children added or removed
+  std::unordered_map<size_t, uint64_t> children;
+  // The world's "instance" array, and the OSPRay array set on the world,
+  // patched slot by slot when instances are replaced
+  std::vector<cpp::Instance> instances;
+  cpp::CopiedData instanceData;
+  // Children of the world modified since the last build
+  std::vector<Node *> changed;
+  TimeStamp lastBuild;
+  // Scene supports in place updates (see RenderScene)
+  bool valid{false};
+};
+
+// A pick resolved to the scene graph, see World::resolvePick()
+struct OSPSG_INTERFACE ScenePick
+{
+  bool hasHit{false};
+  vec3f worldPosition{0.f};
+  uint32_t primID{0};
+  NodePtr instance; // the transform placing the instance hit
+  NodePtr geometry;
+  unsigned int sgInstId{0};
+  unsigned int sgGeomId{0};
+};
+
 struct OSPSG_INTERFACE World : public OSPNode<cpp::World, NodeType::WORLD>
 {
   World();
@@ -16,8 +58,13 @@ struct OSPSG_INTERFACE World : public OSPNode<cpp::World, NodeType::WORLD>
   virtual void preCommit() override;
   virtual void postCommit() override;
 
+  // Looks up the nodes of the instance and geometric model hit
+  ScenePick resolvePick(const cpp::PickResult &result) const;
+
   std::shared_ptr<OSPInstanceSGIdMap> instSGIdMap;
   std::shared_ptr<OSPGeomModelSGIdMap> geomSGIdMap;
+  std::shared_ptr<InstanceCache> instanceCache;
+  std::shared_ptr<PickIdAllocator> pickIds;
 };
 
 } // namespace sg
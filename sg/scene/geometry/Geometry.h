@@ -49,6 +49,10 @@ struct OSPSG_INTERFACE Geometry
   std::vector<vec2f> vt;
   std::vector<uint32_t> mIDs;
 
+  // Keep memory alive which data parameters share without a copy here (ie.
+  // buffers of an imported file), one entry per distinct owner
+  std::vector<std::shared_ptr<const void>> sharedMemoryOwners;
+
   GroupPtr group{nullptr};
   GeometricModelPtr model{nullptr};
 };
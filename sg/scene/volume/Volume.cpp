@@ -41,16 +41,18 @@ template <typename T>
 void Volume::loadVoxels(FILE *file, const vec3i dimensions)
 {
   const size_t nVoxels = dimensions.long_product();
-  std::vector<T> voxels(nVoxels);
+  std::shared_ptr<T> data(new T[nVoxels], std::default_delete<T[]>());
 
-  if (fread(voxels.data(), sizeof(T), nVoxels, file) != nVoxels) {
+  if (fread(data.get(), sizeof(T), nVoxels, file) != nVoxels) {
     throw std::runtime_error(
         "read incomplete data (truncated file or wrong format?!)");
   }
-  const auto minmax = std::minmax_element(begin(voxels), end(voxels));
+  const auto minmax = std::minmax_element(data.get(), data.get() + nVoxels);
   child("valueRange") = range1f(*std::get<0>(minmax), *std::get<1>(minmax));
 
-  createChildData("data", dimensions, 0, voxels.data());
+  // Kept on the host, for the scene cache, instead of copied to OSPRay
+  createChildData("data", dimensions, 0, data.get(), true);
+  voxels = data;
 }
 
 void Volume::load(const FileName &fileNameAbs)
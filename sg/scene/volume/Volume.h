@@ -47,6 +47,10 @@ struct OSPSG_INTERFACE Volume : public OSPNode<cpp::Volume, NodeType::VOLUME>
 
   int groupIndex{-1};
 
+  // Voxels of the "data" parameter, shared with OSPRay.  Loaded, or mapped
+  // from a scene cache which this keeps alive.
+  std::shared_ptr<void> voxels;
+
  private:
   bool fileLoaded{false};
 
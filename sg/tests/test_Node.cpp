@@ -5,12 +5,26 @@
 
 #define protected public
 #include "sg/Node.h"
+#include "sg/visitors/Commit.h"
 #undef protected
 
 using namespace ospray::sg;
 
+#include <algorithm>
+#include <thread>
 #include <type_traits>
 
+// A node type creating its own children, like most registered ones
+struct TestNodeWithChildren : public Node
+{
+  TestNodeWithChildren()
+  {
+    createChild("param", "float", 1.f);
+  }
+};
+
+OSP_REGISTER_SG_NODE_NAME(TestNodeWithChildren, test_node_with_children);
+
 SCENARIO("sg::createNode()")
 {
   GIVEN("A generic node created from sg::createNode()")
@@ -55,6 +69,132 @@ SCENARIO("sg::createNode()")
       REQUIRE(asFloatNode != nullptr);
     }
   }
+
+  GIVEN("Many nodes created and released again")
+  {
+    std::vector<NodePtr> nodes;
+    for (int i = 0; i < 1000; i++)
+      nodes.push_back(createNode("node_" + std::to_string(i), "int", i));
+
+    THEN("Every node keeps its own properties")
+    {
+      for (int i = 0; i < 1000; i++) {
+        REQUIRE(nodes[i]->name() == "node_" + std::to_string(i));
+        REQUIRE(nodes[i]->valueAs<int>() == i);
+      }
+    }
+
+    THEN("Released nodes can be replaced by new ones")
+    {
+      nodes.clear();
+      auto node_ptr = createNode("test_node", "vec3f", vec3f(1.f));
+      REQUIRE(node_ptr->valueAs<vec3f>() == vec3f(1.f));
+      REQUIRE(node_ptr.use_count() == 1);
+    }
+  }
+
+  GIVEN("A registered node type creating children in its constructor")
+  {
+    auto node_ptr = createNode("test_node", "test_node_with_children");
+
+    THEN("The node and its children are created")
+    {
+      REQUIRE(node_ptr->subType() == "test_node_with_children");
+      REQUIRE(node_ptr->child("param").valueAs<float>() == 1.f);
+    }
+  }
+
+  GIVEN("An unknown node type to sg::createNode()")
+  {
+    THEN("Node creation throws")
+    {
+      REQUIRE_THROWS(createNode("test_node", "not_a_node_type"));
+    }
+  }
+}
+
+SCENARIO("sg::Symbol interning")
+{
+  GIVEN("Symbols created from equal and different strings")
+  {
+    Symbol a("vec3f");
+    Symbol b(std::string("vec") + "3f");
+    Symbol c("vec3i");
+
+    THEN("Equal strings share the same interned string")
+    {
+      REQUIRE(a == b);
+      REQUIRE(&a.str() == &b.str());
+      REQUIRE(a != c);
+      REQUIRE(a.str() == "vec3f");
+      REQUIRE(Symbol().empty());
+    }
+
+    THEN("Lookup only finds interned strings")
+    {
+      Symbol found;
+      REQUIRE(Symbol::lookup("vec3i", found));
+      REQUIRE(found == c);
+      REQUIRE(!Symbol::lookup("never_interned_symbol", found));
+    }
+  }
+
+  GIVEN("Nodes of the same subtype")
+  {
+    auto parent_ptr = createNode("parent");
+    parent_ptr->createChild("a", "float", 1.f);
+    parent_ptr->createChild("b", "float", 2.f);
+    parent_ptr->createChild("c", "int", 3);
+
+    THEN("Their subtype strings are shared")
+    {
+      REQUIRE(&parent_ptr->child("a").subType()
+          == &parent_ptr->child("b").subType());
+    }
+
+    THEN("Subtype queries on the children work")
+    {
+      REQUIRE(parent_ptr->hasChildOfSubType("float"));
+      REQUIRE(!parent_ptr->hasChildOfSubType("vec3f"));
+      REQUIRE(!parent_ptr->hasChildOfSubType("never_interned_subtype"));
+      REQUIRE(parent_ptr->childrenOfSubType("float").size() == 2);
+      REQUIRE(parent_ptr->childrenOfSubType("int").size() == 1);
+    }
+  }
+}
+
+SCENARIO("sg::PickIdAllocator")
+{
+  GIVEN("An allocator that handed out many ids")
+  {
+    PickIdAllocator ids;
+    std::vector<unsigned int> given;
+    for (int i = 0; i < 100000; i++)
+      given.push_back(ids.allocate());
+
+    THEN("Every id is unique and non-zero")
+    {
+      auto sorted = given;
+      std::sort(sorted.begin(), sorted.end());
+      REQUIRE(sorted.front() != 0);
+      REQUIRE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+    }
+
+    WHEN("Ids are released")
+    {
+      ids.release(given[10]);
+      ids.release(given[20]);
+
+      THEN("They are handed out again before new ones")
+      {
+        auto a = ids.allocate();
+        auto b = ids.allocate();
+        REQUIRE(std::min(a, b) == std::min(given[10], given[20]));
+        REQUIRE(std::max(a, b) == std::max(given[10], given[20]));
+        REQUIRE(ids.allocate() == given.back() + 1);
+      }
+    }
+  }
 }
 
 SCENARIO("sg::Node interface")
@@ -259,6 +399,305 @@ SCENARIO("sg::Node structural updates")
   }
 }
 
+SCENARIO("sg::Node incremental commit")
+{
+  GIVEN("A committed two level tree")
+  {
+    auto root_ptr = createNode("root");
+    auto &root    = *root_ptr;
+    auto &groupA  = root.createChild("groupA");
+    auto &groupB  = root.createChild("groupB");
+    auto &leafA0  = groupA.createChild("leaf0", "float", 0.f);
+    auto &leafA1  = groupA.createChild("leaf1", "float", 1.f);
+    auto &leafB0  = groupB.createChild("leaf0", "float", 0.f);
+
+    root.commit();
+
+    REQUIRE(!root.isModified());
+    REQUIRE(leafA0.lastModified() < leafA0.lastCommitted());
+    REQUIRE(leafB0.lastModified() < leafB0.lastCommitted());
+
+    WHEN("A single leaf is modified and the root is committed")
+    {
+      auto groupBCommitted = groupB.lastCommitted();
+      auto leafA1Committed = leafA1.lastCommitted();
+      auto leafB0Committed = leafB0.lastCommitted();
+
+      leafA0 = 2.f;
+
+      REQUIRE(root.isModified());
+      REQUIRE(groupA.isModified());
+      REQUIRE(!groupB.isModified());
+
+      root.commit();
+
+      THEN("Only the dirty path is committed")
+      {
+        REQUIRE(!root.isModified());
+        REQUIRE(leafA0.lastModified() < leafA0.lastCommitted());
+        REQUIRE(groupA.lastCommitted() > leafA0.lastCommitted());
+        REQUIRE(root.lastCommitted() > groupA.lastCommitted());
+
+        REQUIRE(groupB.lastCommitted() == groupBCommitted);
+        REQUIRE(leafA1.lastCommitted() == leafA1Committed);
+        REQUIRE(leafB0.lastCommitted() == leafB0Committed);
+      }
+    }
+
+    WHEN("A modified subtree is committed on its own first")
+    {
+      leafB0 = 3.f;
+      groupB.commit();
+
+      THEN("The root still commits cleanly afterwards")
+      {
+        REQUIRE(!groupB.isModified());
+        REQUIRE(root.isModified());
+
+        root.commit();
+
+        REQUIRE(!root.isModified());
+      }
+    }
+
+    WHEN("A dirty child is removed before the commit")
+    {
+      leafA1 = 4.f;
+      groupA.remove("leaf1");
+      root.commit();
+
+      THEN("The tree is clean")
+      {
+        REQUIRE(!root.isModified());
+        REQUIRE(!groupA.hasChild("leaf1"));
+      }
+    }
+  }
+}
+
+SCENARIO("sg::Node parallel commit")
+{
+  GIVEN("A committed tree with many independent subtrees")
+  {
+    auto root_ptr = createNode("root");
+    auto &root    = *root_ptr;
+
+    const int numGroups = 64;
+    std::vector<Node *> leaves;
+    for (int i = 0; i < numGroups; i++) {
+      auto &group = root.createChild("group_" + std::to_string(i));
+      leaves.push_back(&group.createChild("leaf", "int", i));
+    }
+
+    root.commit();
+    REQUIRE(!root.isModified());
+
+    WHEN("Every subtree is modified and the root is committed in parallel")
+    {
+      commitSettings.parallel = true;
+      for (auto *leaf : leaves)
+        *leaf = -1;
+
+      root.commit();
+
+      THEN("The whole tree is committed")
+      {
+        REQUIRE(!root.isModified());
+        for (auto &group : root.children()) {
+          REQUIRE(!group.second->isModified());
+          REQUIRE(group.second->lastCommitted() < root.lastCommitted());
+        }
+        for (auto *leaf : leaves)
+          REQUIRE(leaf->lastModified() < leaf->lastCommitted());
+      }
+    }
+
+    WHEN("A modified node is shared between subtrees")
+    {
+      auto shared_ptr = createNode("shared", "int", 0);
+      for (auto &group : root.children())
+        group.second->add(shared_ptr);
+      root.commit();
+
+      *shared_ptr = 1;
+      for (auto *leaf : leaves)
+        *leaf = -1;
+
+      root.commit();
+
+      THEN("The tree is committed serially without problems")
+      {
+        REQUIRE(!root.isModified());
+        REQUIRE(!shared_ptr->isModified());
+      }
+    }
+
+    WHEN("A subtree holds a modified node of a type not known to be "
+         "self-contained")
+    {
+      auto &group  = *root.children().at_index(0).second;
+      auto special = createNode("special", "test_node_with_children");
+      group.add(special);
+      root.commit();
+
+      special->child("param") = 2.f;
+      for (auto *leaf : leaves)
+        *leaf = -1;
+
+      THEN("Its siblings are committed serially")
+      {
+        CommitVisitor visitor;
+        REQUIRE(!visitor.isIsolated(group));
+        REQUIRE(visitor.isIsolated(*root.children().at_index(1).second));
+
+        root.commit();
+        REQUIRE(!root.isModified());
+        REQUIRE(!special->isModified());
+      }
+    }
+
+    WHEN("Parallel commit is disabled")
+    {
+      commitSettings.parallel = false;
+      for (auto *leaf : leaves)
+        *leaf = -2;
+
+      root.commit();
+      commitSettings.parallel = true;
+
+      THEN("The whole tree is committed serially")
+      {
+        REQUIRE(!root.isModified());
+        for (auto *leaf : leaves)
+          REQUIRE(leaf->lastModified() < leaf->lastCommitted());
+      }
+    }
+  }
+}
+
+SCENARIO("sg::Node concurrent construction")
+{
+  GIVEN("Nodes shared by several threads building their own subtrees")
+  {
+    auto root_ptr   = createNode("root");
+    auto shared_ptr = createNode("shared", "int", 0);
+
+    const int numThreads = 8;
+    const int numNodes   = 200;
+
+    std::vector<NodePtr> subtrees(numThreads);
+    std::vector<std::thread> builders;
+    for (int t = 0; t < numThreads; t++) {
+      builders.emplace_back([&, t]() {
+        auto subtree = createNode("subtree_" + std::to_string(t));
+        for (int i = 0; i < numNodes; i++) {
+          auto &n = subtree->createChild("node_" + std::to_string(i), "int");
+          n.add(shared_ptr);
+          n = i;
+          shared_ptr->markAsModified();
+          if (i % 2)
+            n.remove("shared");
+        }
+        subtrees[t] = subtree;
+      });
+    }
+    for (auto &b : builders)
+      b.join();
+
+    THEN("Every link to the shared node is accounted for")
+    {
+      REQUIRE(shared_ptr->parents().size() == numThreads * numNodes / 2);
+    }
+
+    THEN("The attached subtrees commit cleanly")
+    {
+      for (auto &subtree : subtrees)
+        root_ptr->add(subtree);
+      root_ptr->commit();
+
+      REQUIRE(!root_ptr->isModified());
+      REQUIRE(!shared_ptr->isModified());
+    }
+  }
+}
+
+SCENARIO("sg::Node with many children")
+{
+  GIVEN("A node with more children than the hashed lookup threshold")
+  {
+    auto parent_ptr = createNode("parent_node");
+    auto &parent    = *parent_ptr;
+
+    const int numChildren = 100;
+    for (int i = 0; i < numChildren; i++)
+      parent.createChild("child_" + std::to_string(i), "int", i);
+
+    THEN("Every child is found by name")
+    {
+      for (int i = 0; i < numChildren; i++) {
+        auto name = "child_" + std::to_string(i);
+        REQUIRE(parent.hasChild(name));
+        REQUIRE(parent[name].valueAs<int>() == i);
+      }
+      REQUIRE(!parent.hasChild("child_" + std::to_string(numChildren)));
+    }
+
+    THEN("Children are iterated in insertion order")
+    {
+      int i = 0;
+      for (auto &c : parent.children())
+        REQUIRE(c.second->valueAs<int>() == i++);
+    }
+
+    WHEN("A child in the middle is removed")
+    {
+      parent.remove("child_10");
+
+      THEN("Lookup and order of the remaining children are unchanged")
+      {
+        REQUIRE(!parent.hasChild("child_10"));
+        REQUIRE(parent.children().size() == numChildren - 1);
+        REQUIRE(parent["child_11"].valueAs<int>() == 11);
+        REQUIRE(parent.children().at_index(10).first == "child_11");
+      }
+    }
+
+    WHEN("Children are removed in scattered order and others added")
+    {
+      for (int i = 0; i < numChildren; i += 3)
+        parent.remove("child_" + std::to_string(i));
+      parent.createChild("child_new", "int", -1);
+
+      THEN("The remaining children keep their order and lookup")
+      {
+        std::vector<int> remaining;
+        for (int i = 0; i < numChildren; i++)
+          if (i % 3)
+            remaining.push_back(i);
+        remaining.push_back(-1);
+
+        REQUIRE(parent.children().size() == remaining.size());
+        size_t i = 0;
+        for (auto &c : parent.children())
+          REQUIRE(c.second->valueAs<int>() == remaining[i++]);
+        for (i = 0; i < remaining.size(); i++)
+          REQUIRE(parent.children().at_index(i).second->valueAs<int>()
+              == remaining[i]);
+        REQUIRE(!parent.hasChild("child_3"));
+        REQUIRE(parent["child_4"].valueAs<int>() == 4);
+        REQUIRE(parent.children().crbegin()->first == "child_new");
+      }
+
+      THEN("Removing all children empties the node")
+      {
+        parent.removeAllChildren();
+        REQUIRE(!parent.hasChildren());
+        REQUIRE(parent.children().begin() == parent.children().end());
+      }
+    }
+  }
+}
+
 SCENARIO("sg::Node_T<> interface")
 {
   GIVEN("A freshly created sg::FloatNode")
@@ -303,5 +742,26 @@ SCENARIO("sg::Node_T<> interface")
       float value = floatNode;
       REQUIRE(value == 1.f);
     }
+
+    THEN("Assigning a value of the same type updates it in place")
+    {
+      const float *storage = &floatNode.value();
+      floatNode = 3.f;
+
+      REQUIRE(&floatNode.value() == storage);
+      REQUIRE(floatNode.value() == 3.f);
+    }
+
+    THEN("Assigning an unchanged value does not mark the node modified")
+    {
+      floatNode.commit();
+      auto lastModified = floatNode.lastModified();
+
+      floatNode = 1.f;
+      REQUIRE(floatNode.lastModified() == lastModified);
+
+      floatNode = 5.f;
+      REQUIRE(floatNode.lastModified() > lastModified);
+    }
   }
 }
@@ -458,7 +458,8 @@ bool Texture2D::load(const FileName &_fileName,
     const bool _preferLinear,
     const bool _nearestFilter,
     const int _colorChannel,
-    const void *memory)
+    const void *memory,
+    std::shared_ptr<void> sharedMemory)
 {
   bool success = false;
   // Not a true filename in the case memory != nullptr (since texture is
@@ -475,7 +476,14 @@ bool Texture2D::load(const FileName &_fileName,
       texelData = cache->texelData;
     }
   } else {
-    if (memory) {
+    if (sharedMemory) {
+      params.inMemory = true;
+      texelData = sharedMemory;
+
+      // Add this texture to the cache
+      textureCache[fileName] = this->nodeAs<Texture2D>();
+    } else if (memory) {
+      params.inMemory = true;
       size_t size = params.size.product() * params.components * params.depth;
       std::shared_ptr<void> data(new uint8_t[size]);
       std::memcpy(data.get(), memory, size);
@@ -30,12 +30,20 @@ struct OSPSG_INTERFACE Texture2D : public Texture
   //! \brief load texture from given file or memory address.
   /*! \detailed if file does not exist, or cannot be loaded for
       some reason, return NULL. Multiple loads from the same file
-      will return the *same* texture object */
+      will return the *same* texture object.  Texels in 'sharedMemory' are
+      shared rather than copied, it keeps their owner alive */
   bool load(const FileName &fileName,
       const bool preferLinear = false,
       const bool nearestFilter = false,
       const int colorChannel = 4, // default to sampling all channels
-      const void *memory = nullptr);
+      const void *memory = nullptr,
+      std::shared_ptr<void> sharedMemory = nullptr);
+
+  // The loaded texels, params.size.product() * components * depth bytes
+  const void *texels() const
+  {
+    return texelData.get();
+  }
 
   std::string fileName;
 
@@ -78,6 +86,7 @@ struct OSPSG_INTERFACE Texture2D : public Texture
     bool nearestFilter{false};
     int colorChannel{4}; // sampled channel R(0), G(1), B(2), A(3), all(4)
     bool flip{true}; // flip texture data vertically when loading from file
+    bool inMemory{false}; // texels given to load(), not read from fileName
   } params;
 
  private:
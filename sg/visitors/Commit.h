@@ -4,10 +4,33 @@
 #pragma once
 
 #include "../Node.h"
+// rkcommon
+#include "rkcommon/tasking/parallel_for.h"
+// stl
+#include <algorithm>
+#include <mutex>
 
 namespace ospray {
   namespace sg {
 
+  // Global commit settings ///////////////////////////////////////////////////
+
+  struct OSPSG_INTERFACE CommitSettings
+  {
+    // Commit independent sibling subtrees concurrently.  Subtrees are only
+    // committed in parallel if none of their dirty nodes is shared with
+    // another subtree, and all of them are of a type whose pre/postCommit()
+    // only touches its own subtree (see CommitVisitor::isSelfContained()).
+    // Set false to always commit serially.
+    bool parallel{true};
+    // Fewer dirty siblings than this are always committed serially
+    size_t minParallelChildren{16};
+  };
+
+  extern OSPSG_INTERFACE CommitSettings commitSettings;
+
+  // CommitVisitor ////////////////////////////////////////////////////////////
+
   struct CommitVisitor : public Visitor
   {
     CommitVisitor()           = default;
@@ -15,7 +38,22 @@ namespace ospray {
 
     bool operator()(Node &node, TraversalContext &) override;
     void postChildren(Node &node, TraversalContext &) override;
+
+    // Commit 'node', only descending into children registered as dirty
+    // (preCommit() -> dirty children in child order -> postCommit()).
+    // Unlike traverse<CommitVisitor>(), cost scales with the number of
+    // modified nodes rather than with the size of the tree.
+    void commit(Node &node);
+
     protected:
+    void commitSubtree(Node &node, bool isolated);
+    void commitChildren(std::vector<Node *> &children, bool isolated);
+
+    std::vector<Node *> dirtyChildrenInOrder(Node &node,
+                                             std::vector<Node *> &dirty);
+
+    bool isIsolated(Node &node);
+    bool isSelfContained(const Node &node);
   };
 
   // Inlined definitions //////////////////////////////////////////////////////
@@ -34,7 +72,152 @@ namespace ospray {
   {
     if (node.subtreeModifiedButNotCommitted()) {
       node.postCommit();
-      node.properties.lastCommitted.renew();
+      node.markCommitted();
+    }
+  }
+
+  inline void CommitVisitor::commit(Node &node)
+  {
+    if (!node.subtreeModifiedButNotCommitted())
+      return;
+
+    commitSubtree(node, false);
+    node.markCommitted();
+  }
+
+  // Everything but markCommitted(), which may register 'node' with its
+  // parents again and so is left to the caller.  'isolated' means no node
+  // below is shared with another subtree (known once a parent went parallel).
+  inline void CommitVisitor::commitSubtree(Node &node, bool isolated)
+  {
+    node.preCommit();
+
+    // preCommit() may dirty children itself, so only take the list now
+    auto dirty = node.takeDirtyChildren();
+
+    auto children = dirtyChildrenInOrder(node, dirty);
+    commitChildren(children, isolated);
+
+    node.postCommit();
+  }
+
+  inline void CommitVisitor::commitChildren(
+      std::vector<Node *> &children, bool isolated)
+  {
+    auto numChildren = children.size();
+
+    bool parallel = commitSettings.parallel
+        && numChildren >= commitSettings.minParallelChildren;
+    if (parallel && !isolated)
+      parallel = std::all_of(children.begin(),
+          children.end(),
+          [&](Node *c) { return isIsolated(*c); });
+
+    if (!parallel) {
+      for (auto *child : children) {
+        if (child->subtreeModifiedButNotCommitted()) {
+          commitSubtree(*child, isolated);
+          child->markCommitted();
+        }
+      }
+      return;
+    }
+
+    // Sibling subtrees are independent, but markCommitted() touches the
+    // (shared) parent if a child stays dirty, so finish those serially.
+    std::vector<char> committed(numChildren, false);
+    tasking::parallel_for(numChildren, [&](size_t i) {
+      auto *child = children[i];
+      if (child->subtreeModifiedButNotCommitted()) {
+        commitSubtree(*child, true);
+        committed[i] = true;
+      }
+    });
+
+    for (size_t i = 0; i < numChildren; i++)
+      if (committed[i])
+        children[i]->markCommitted();
+  }
+
+  inline std::vector<Node *> CommitVisitor::dirtyChildrenInOrder(
+      Node &node, std::vector<Node *> &dirty)
+  {
+    auto &children = node.properties.children;
+    std::vector<Node *> ordered;
+
+    // When most children are dirty anyway, a plain in-order walk is cheaper
+    // than sorting; commit() skips the ones that turn out to be clean.
+    if (dirty.size() * 8 >= children.size()) {
+      ordered.reserve(children.size());
+      for (auto &c : children)
+        ordered.push_back(c.second.get());
+      return ordered;
+    }
+
+    // Otherwise, restore child order of the (few) dirty children
+    std::vector<std::pair<size_t, Node *>> indexed;
+    indexed.reserve(dirty.size());
+    for (auto *c : dirty) {
+      auto itr = children.find(c->name());
+      if (itr == children.end() || itr->second.get() != c) {
+        // added under a different name than its own
+        itr = std::find_if(children.begin(),
+            children.end(),
+            [&](const Node::NodeLink &l) { return l.second.get() == c; });
+      }
+      if (itr != children.end())
+        indexed.emplace_back(std::distance(children.begin(), itr), c);
+    }
+
+    std::sort(indexed.begin(), indexed.end());
+    indexed.erase(std::unique(indexed.begin(), indexed.end()), indexed.end());
+
+    ordered.reserve(indexed.size());
+    for (auto &i : indexed)
+      ordered.push_back(i.second);
+    return ordered;
+  }
+
+  inline bool CommitVisitor::isIsolated(Node &node)
+  {
+    if (!isSelfContained(node))
+      return false;
+
+    // Only the dirty paths get committed, so only those need checking.
+    // Background tasks may link nodes meanwhile.
+    std::vector<Node *> dirty;
+    {
+      std::lock_guard<std::mutex> lock(node.properties.linkMutex);
+      if (node.properties.parents.size() > 1)
+        return false;
+      for (auto &c : node.properties.dirtyChildren)
+        dirty.push_back(c.first);
+    }
+
+    for (auto *c : dirty)
+      if (!isIsolated(*c))
+        return false;
+
+    return true;
+  }
+
+  // Node types known to commit without touching nodes outside their own
+  // subtree.  Others (ie. the material registry, which commits the
+  // renderer's materials, or lights and the world) keep the serial path.
+  inline bool CommitVisitor::isSelfContained(const Node &node)
+  {
+    switch (node.type()) {
+    case NodeType::PARAMETER:
+    case NodeType::TRANSFORM:
+    case NodeType::GEOMETRY:
+    case NodeType::MATERIAL:
+    case NodeType::TEXTURE:
+      return true;
+    case NodeType::GENERIC:
+      // Plain grouping nodes only, derived types may override the hooks
+      return node.subType() == "Node";
+    default:
+      return false;
     }
   }
 
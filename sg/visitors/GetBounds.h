@@ -4,37 +4,281 @@
 #pragma once
 
 #include "../Node.h"
+#include "../scene/geometry/Geometry.h"
+// stl
+#include <algorithm>
 
 namespace ospray {
   namespace sg {
 
-  struct GetBounds : public Visitor
+  // Bounds of a subtree, in the space of its root's parent (ie. including the
+  // root's own transform).  Computed from SG-side data where possible, so
+  // nothing needs committing first.
+  //
+  // Results are cached per node.  Modifications invalidate the caches up to
+  // the root (see Node::markBoundsModified()), registering the modified child
+  // with each ancestor, so queries only revisit the modified paths.  Parents
+  // are updated in place from their modified children, unless one of those
+  // may have defined the old bounds, which merges all children again.
+  //
+  // NOTE: not thread safe, bounds are queried from one thread at a time
+  struct GetBounds
   {
-    GetBounds() = default;
+    box3f operator()(Node &node);
 
-    bool operator()(Node &node, TraversalContext &ctx) override;
+   private:
+    box3f subtreeBounds(Node &node, bool &cacheable);
+    box3f childrenBounds(Node &node,
+        bool contentModified,
+        std::vector<Node *> &modified,
+        bool &cacheable);
 
-    box3f bounds;
+    box3f geometryBounds(Node &node, bool &cacheable);
+    bool sharedPositionBounds(Node &node, box3f &bounds);
+    box3f volumeBounds(Node &node);
+    affine3f localTransform(Node &node);
+
+    void validateParams(Node &node);
+
+    // Whether replacing 'previous' by 'updated' may shrink 'bounds', ie.
+    // 'previous' reached a face of 'bounds' which 'updated' doesn't
+    static bool retracts(const box3f &bounds,
+        const box3f &previous,
+        const box3f &updated);
   };
 
   // Inlined definitions //////////////////////////////////////////////////////
 
-  inline bool GetBounds::operator()(Node &node, TraversalContext &)
+  inline box3f GetBounds::operator()(Node &node)
   {
+    bool cacheable = true;
+    return subtreeBounds(node, cacheable);
+  }
+
+  inline box3f GetBounds::subtreeBounds(Node &node, bool &cacheable)
+  {
+    auto &cache = node.properties.boundsCache;
+
+    // Parameters don't have bounds, but notify their parents of changes
+    // once visited
+    if (node.type() == NodeType::PARAMETER) {
+      cache.valid = true;
+      return box3f();
+    }
+
+    if (cache.valid)
+      return cache.bounds;
+
+    // Validated first, so modifications while computing aren't lost
+    bool contentModified = true;
+    std::vector<Node *> modified;
+    {
+      std::lock_guard<std::mutex> lock(node.properties.linkMutex);
+      contentModified = cache.contentModified;
+      cache.contentModified = false;
+      modified.swap(cache.modifiedChildren);
+      cache.valid = true;
+    }
+
+    bool subtreeCacheable = true;
+    cache.fromOSPRay = false;
+
     switch (node.type()) {
-    case NodeType::WORLD: {
-      auto world = node.valueAs<cpp::World>();
-      bounds     = world.getBounds<box3f>();
-      return false;
+    case NodeType::GEOMETRY:
+      cache.local = geometryBounds(node, subtreeCacheable);
+      validateParams(node);
+      break;
+    case NodeType::VOLUME:
+      cache.local = volumeBounds(node);
+      validateParams(node);
+      break;
+    default:
+      cache.local =
+          childrenBounds(node, contentModified, modified, subtreeCacheable);
+      break;
+    }
+
+    cache.bounds = cache.local;
+    if (node.type() == NodeType::TRANSFORM && !cache.local.empty())
+      cache.bounds = xfmBounds(localTransform(node), cache.local);
+
+    if (!subtreeCacheable) {
+      cache.valid = false;
+      cache.contentModified = true;
+      cacheable = false;
     }
-    case NodeType::GEOMETRY: {
-      auto geom = node.valueAs<cpp::Geometry>();
-      bounds    = geom.getBounds<box3f>();
+
+    return cache.bounds;
+  }
+
+  inline box3f GetBounds::childrenBounds(Node &node,
+      bool contentModified,
+      std::vector<Node *> &modified,
+      bool &cacheable)
+  {
+    auto &local = node.properties.boundsCache.local;
+
+    // Modified children are only known to still be children if the node
+    // itself (ie. its list of children) wasn't modified
+    bool merge = !contentModified;
+    if (merge) {
+      std::sort(modified.begin(), modified.end());
+      modified.erase(
+          std::unique(modified.begin(), modified.end()), modified.end());
+
+      box3f bounds = local;
+      for (auto *c : modified) {
+        if (c->type() == NodeType::PARAMETER) {
+          c->properties.boundsCache.valid = true;
+          continue;
+        }
+
+        // The previous bounds of a child shared with other parents may
+        // already have been replaced while visiting those
+        if (c->parents().size() != 1) {
+          merge = false;
+          break;
+        }
+
+        const box3f previous = c->properties.boundsCache.bounds;
+        const box3f updated = subtreeBounds(*c, cacheable);
+        if (retracts(local, previous, updated)) {
+          merge = false;
+          break;
+        }
+        bounds.extend(updated);
+      }
+
+      if (merge)
+        return bounds;
+    }
+
+    // Children computed above return their cached bounds now
+    box3f bounds;
+    for (auto &c : node.children())
+      bounds.extend(subtreeBounds(*c.second, cacheable));
+    return bounds;
+  }
+
+  inline box3f GetBounds::geometryBounds(Node &node, bool &cacheable)
+  {
+    box3f bounds;
+
+    if (node.hasChild("visible") && !node.child("visible").valueAs<bool>())
+      return bounds;
+
+    auto &geom = *node.nodeAs<Geometry>();
+    const bool isSpheres = node.subType() == "geometry_spheres";
+    auto &positions = geom.skinnedPositions.empty() ? geom.positions
+                                                    : geom.skinnedPositions;
+
+    // Only the arrays kept in the Geometry node are known here, anything
+    // else (ie. per sphere radii) needs OSPRay's bounds of the committed
+    // geometry
+    const bool hostPositions = !positions.empty()
+        && (node.subType() == "geometry_triangles"
+            || node.subType() == "geometry_subdivision"
+            || (isSpheres && !node.hasChild("sphere.radius")));
+
+    if (!hostPositions) {
+      if (sharedPositionBounds(node, bounds))
+        return bounds;
+      node.properties.boundsCache.fromOSPRay = true;
+      auto ospGeom = node.valueAs<cpp::Geometry>();
+      return ospGeom.getBounds<box3f>();
+    }
+
+    for (auto &p : positions)
+      bounds.extend(p);
+
+    if (isSpheres) {
+      const float radius = node.hasChild("radius")
+          ? node.child("radius").valueAs<float>()
+          : 0.01f; // OSPRay's default
+      bounds.lower -= radius;
+      bounds.upper += radius;
+    }
+
+    // skinned positions change with their joints, not with the geometry
+    if (geom.skin)
+      cacheable = false;
+
+    return bounds;
+  }
+
+  // Bounds of triangle positions shared directly from imported buffers,
+  // which the Geometry node doesn't keep a copy of
+  inline bool GetBounds::sharedPositionBounds(Node &node, box3f &bounds)
+  {
+    if ((node.subType() != "geometry_triangles"
+            && node.subType() != "geometry_subdivision")
+        || !node.hasChild("vertex.position"))
+      return false;
+
+    auto *data = dynamic_cast<Data *>(&node.child("vertex.position"));
+    if (!data || !data->sharedMemory || data->format != OSP_VEC3F)
       return false;
+
+    auto *bytes = static_cast<const uint8_t *>(data->sharedMemory);
+    const size_t stride = data->byteStride.x ? data->byteStride.x
+                                             : sizeof(vec3f);
+    for (size_t i = 0; i < data->numItems.x; i++)
+      bounds.extend(*reinterpret_cast<const vec3f *>(bytes + i * stride));
+    return true;
+  }
+
+  inline box3f GetBounds::volumeBounds(Node &node)
+  {
+    if (node.hasChild("visible") && !node.child("visible").valueAs<bool>())
+      return box3f();
+
+    if (node.subType() == "structuredRegular" && node.hasChild("dimensions")
+        && node.hasChild("gridOrigin") && node.hasChild("gridSpacing")) {
+      const vec3i dims = node.child("dimensions").valueAs<vec3i>();
+      const vec3f origin = node.child("gridOrigin").valueAs<vec3f>();
+      const vec3f spacing = node.child("gridSpacing").valueAs<vec3f>();
+      return box3f(origin, origin + vec3f(dims - 1) * spacing);
     }
-    default:
-      return true;
+
+    node.properties.boundsCache.fromOSPRay = true;
+    auto ospVolume = node.valueAs<cpp::Volume>();
+    return ospVolume.getBounds<box3f>();
+  }
+
+  inline affine3f GetBounds::localTransform(Node &node)
+  {
+    // Same composition as RenderScene, start of the shutter interval only
+    affine3f xfm =
+        affine3f::rotate(node.child("rotation").valueAs<quaternionf>());
+    xfm *= affine3f::scale(node.child("scale").valueAs<vec3f>());
+    xfm.p = node.child("translation").valueAs<vec3f>();
+    return xfm * node.valueAs<affine3f>();
+  }
+
+  inline void GetBounds::validateParams(Node &node)
+  {
+    for (auto &c : node.children()) {
+      if (c.second->type() == NodeType::PARAMETER)
+        c.second->properties.boundsCache.valid = true;
+    }
+  }
+
+  inline bool GetBounds::retracts(
+      const box3f &bounds, const box3f &previous, const box3f &updated)
+  {
+    if (previous.empty())
+      return false;
+
+    for (int dim = 0; dim < 3; dim++) {
+      if (previous.lower[dim] <= bounds.lower[dim]
+          && !(updated.lower[dim] <= previous.lower[dim]))
+        return true;
+      if (previous.upper[dim] >= bounds.upper[dim]
+          && !(updated.upper[dim] >= previous.upper[dim]))
+        return true;
     }
+
+    return false;
   }
 
   }  // namespace sg
@@ -14,12 +14,36 @@
 #include "sg/scene/lights/Light.h"
 #include "sg/scene/volume/Volume.h"
 
+// rkcommon
+#include "rkcommon/tasking/parallel_for.h"
 // std
+#include <algorithm>
 #include <stack>
 
 namespace ospray {
   namespace sg {
 
+  // Weighted sum of a vertex's joint matrices.  Works on the 12 floats of
+  // the matrices as flat arrays, which compilers turn into SIMD multiply-adds.
+  inline affine3f blendJoints(const affine3f *palette,
+      const uint16_t *joints,
+      const float *weights,
+      size_t numWeights)
+  {
+    static_assert(sizeof(affine3f) == 12 * sizeof(float),
+        "blendJoints() expects tightly packed matrices");
+
+    affine3f xfm{zero};
+    float *dst = &xfm.l.vx.x;
+    for (size_t j = 0; j < numWeights; ++j) {
+      const float *src = &palette[joints[j]].l.vx.x;
+      const float w = weights[j];
+      for (int k = 0; k < 12; ++k)
+        dst[k] += w * src[k];
+    }
+    return xfm;
+  }
+
   struct RenderScene : public Visitor
   {
     RenderScene();
@@ -36,18 +60,20 @@ namespace ospray {
     void createInstanceFromGroup(Node &node);
     void placeInstancesInWorld();
     void setLightParams(Node &node);
+    void setGroupParams(Node &node, cpp::Group &group);
+    void setInstanceTransform(cpp::Instance &inst);
 
-    unsigned int getInstId()
-    {
-      static unsigned int inst_counter = 1;
-      return inst_counter++;
-    }
+    // Picking //
+    void registerInstance(Node &node, cpp::Instance &inst);
+    void registerModel(Node &node, OSPGeometricModel model);
+    void releaseUnused();
+    unsigned int assignPickId(Transform &xfm, unsigned int &id);
 
-    unsigned int getGeomId()
-    {
-      static unsigned int geom_counter = 1;
-      return geom_counter++;
-    }
+    // Incremental updates //
+    bool skipSubtree(Node &node);
+    uint64_t childrenHash(Node &node);
+    void updateInstances(Node &node);
+    void updateGroupedLight(Node &node);
 
     // Data //
 
@@ -76,9 +102,25 @@ namespace ospray {
     std::stack<cpp::TransferFunction> tfns;
     std::shared_ptr<OSPInstanceSGIdMap> instSGIdMap{nullptr};
     std::shared_ptr<OSPGeomModelSGIdMap> geomSGIdMap{nullptr};
+    std::shared_ptr<PickIdAllocator> pickIds{nullptr};
     Node *instRoot{nullptr};
-    unsigned int sgGeomId;
-    unsigned int sgInstId;
+    unsigned int sgGeomId{0};
+    unsigned int sgInstId{0};
+
+    // When only parameters changed since the last build, the cached instances
+    // of the world are updated in place and unchanged subtrees are skipped
+    std::shared_ptr<InstanceCache> cache{nullptr};
+    bool incremental{false};
+    bool abandoned{false}; // found a change which needs a full rebuild
+    bool cacheValid{true};
+    Node *skipped{nullptr};
+    std::stack<bool> xfmsChanged;
+
+    // Full rebuilds take over the instances (and picking ids) of the last
+    // build where their groups are unchanged, what's left is released
+    std::unordered_map<size_t, std::vector<InstanceCache::Entry>>
+        previousEntries;
+    std::unordered_map<size_t, OSPGeometricModel> previousModels;
   };
 
   // Inlined definitions //////////////////////////////////////////////////////
@@ -88,6 +130,7 @@ namespace ospray {
     xfms.emplace(math::one);
     endXfms.emplace(math::one);
     xfmsDiverged.emplace(false);
+    xfmsChanged.emplace(false);
   }
 
   inline RenderScene::~RenderScene()
@@ -97,6 +140,11 @@ namespace ospray {
 
   inline bool RenderScene::operator()(Node &node, TraversalContext &)
   {
+    if (incremental && skipSubtree(node)) {
+      skipped = &node;
+      return false;
+    }
+
     bool traverseChildren = true;
 
     switch (node.type()) {
@@ -104,9 +152,25 @@ namespace ospray {
       world = node.valueAs<cpp::World>();
       auto worldNode = node.nodeAs<World>();
       instSGIdMap = worldNode->instSGIdMap;
-      instSGIdMap->clear();
       geomSGIdMap = worldNode->geomSGIdMap;
-      geomSGIdMap->clear();
+      pickIds = worldNode->pickIds;
+      cache = worldNode->instanceCache;
+      incremental = cache->valid && !sgUsingMpi();
+      if (incremental) {
+        abandoned = node.lastModified() > cache->lastBuild;
+
+        // Visit only the changed children, not all of them
+        for (auto *child : cache->changed)
+          child->traverse(*this);
+        traverseChildren = false;
+      } else {
+        previousEntries.swap(cache->entries);
+        previousModels.swap(cache->models);
+        cache->entries.clear();
+        cache->models.clear();
+        cache->children.clear();
+      }
+      cache->changed.clear();
     } break;
     case NodeType::MATERIAL_REFERENCE:
       materialIDs.push(node.valueAs<int>());
@@ -151,6 +215,10 @@ namespace ospray {
         endXfm.p = xfm.p;
 
       auto xfmNode = node.nodeAs<Transform>();
+      const affine3f prevXfm = xfmNode->accumulatedXfm;
+      const affine3f prevEndXfm = xfmNode->accumulatedEndXfm;
+      const bool prevMotionBlur = xfmNode->motionBlur;
+
       xfmNode->localXfm = xfm * node.valueAs<affine3f>();
       xfmNode->accumulatedXfm = xfms.top() * xfmNode->localXfm;
       xfms.push(xfmNode->accumulatedXfm);
@@ -159,26 +227,21 @@ namespace ospray {
       endXfms.push(xfmNode->accumulatedEndXfm);
       xfmNode->motionBlur = xfmsDiverged.top() || diverged;
       xfmsDiverged.push(xfmNode->motionBlur);
+      xfmsChanged.push(xfmNode->accumulatedXfm != prevXfm
+          || xfmNode->accumulatedEndXfm != prevEndXfm
+          || xfmNode->motionBlur != prevMotionBlur);
+
+      if (cache && !incremental)
+        cache->children[node.uniqueID()] = childrenHash(node);
 
+      // SG ids for picking, kept by the node for every later build
       if (!instRoot && node.hasChild("instanceId")) {
         instRoot = &node;
-        if (!node.hasChild("sgInstId")) {
-          sgInstId = reduce24(getInstId());
-          // for a node create SG-ids only once in SG
-          node.createChild("sgInstId", "uint32_t", sgInstId);
-          node.child("sgInstId").setSGOnly();
-          node.child("sgInstId").setSGNoUI();
-        } else if (node.hasChild("sgInstId"))
-          sgInstId = node.child("sgInstId").valueAs<unsigned int>();
+        sgInstId = assignPickId(*xfmNode, xfmNode->sgInstId);
       }
 
-      if (node.hasChild("geomId") && !node.hasChild("sgGeomId")) {
-        sgGeomId = reduce24(getGeomId());
-        node.createChild("sgGeomId", "uint32_t", sgGeomId);
-        node.child("sgGeomId").setSGOnly();
-        node.child("sgGeomId").setSGNoUI();
-      } else if (node.hasChild("sgGeomId"))
-        sgGeomId = node.child("sgGeomId").valueAs<unsigned int>();
+      if (node.hasChild("geomId"))
+        sgGeomId = assignPickId(*xfmNode, xfmNode->sgGeomId);
 
       break;
     }
@@ -210,8 +273,19 @@ namespace ospray {
 
   inline void RenderScene::postChildren(Node &node, TraversalContext &)
   {
+    if (&node == skipped) {
+      skipped = nullptr;
+      return;
+    }
+
     switch (node.type()) {
     case NodeType::WORLD:
+      if (abandoned) {
+        // Can't be updated in place after all, rebuild everything
+        cache->valid = false;
+        node.traverse<RenderScene>();
+        break;
+      }
       placeInstancesInWorld();
       if (sgUsingMpi()) {
         if (worldRegions.size()) {
@@ -219,6 +293,10 @@ namespace ospray {
         }
       }
       world.commit();
+      if (!incremental)
+        releaseUnused();
+      cache->valid = cacheValid;
+      cache->lastBuild.renew();
       break;
     case NodeType::TRANSFER_FUNCTION:
       tfns.pop();
@@ -230,19 +308,23 @@ namespace ospray {
       // Only lights marked as "inGroup" belong in a group lights list, others
       // have been put on the world list.
       if (node.nodeAs<Light>()->inGroup) {
+        if (incremental) {
+          updateGroupedLight(node);
+          break;
+        }
+
         auto &light = node.valueAs<cpp::Light>();
         cpp::Group group;
         group.setParam("light", cpp::CopiedData(light));
         group.commit();
         cpp::Instance inst(group);
-        if (xfmsDiverged.top()) { // motion blur
-          std::vector<affine3f> motionXfms;
-          motionXfms.push_back(xfms.top());
-          motionXfms.push_back(endXfms.top());
-          inst.setParam("motion.transform", cpp::CopiedData(motionXfms));
-        } else
-          inst.setParam("transform", xfms.top());
-        inst.commit();
+        setInstanceTransform(inst);
+
+        if (cache) {
+          if (cache->entries.count(node.uniqueID()))
+            cacheValid = false; // reached through several paths
+          cache->entries[node.uniqueID()].push_back({group, inst, instances.size()});
+        }
         instances.push_back(inst);
       }
     } break;
@@ -251,11 +333,12 @@ namespace ospray {
       xfms.pop();
       endXfms.pop();
       xfmsDiverged.pop();
-      if (&node == instRoot)
+      xfmsChanged.pop();
+      if (&node == instRoot) {
         instRoot = nullptr;
-      if (node.hasChild("sgInstId"))
         sgInstId = 0;
-      if (node.hasChild("sgGeomId"))
+      }
+      if (node.hasChild("geomId"))
         sgGeomId = 0;
 
       break;
@@ -275,53 +358,70 @@ namespace ospray {
 
     // skinning
     if (geomNode->skin) {
+      // joints may be anywhere in the scene, so always rebuild
+      cacheValid = false;
+
       auto &joints = geomNode->skin->joints;
       auto &inverseBindMatrices = geomNode->skin->inverseBindMatrices;
       const size_t weightsPerVertex = geomNode->weightsPerVertex;
+      const size_t numVertices = geomNode->positions.size();
+      const bool hasNormals = !geomNode->skinnedNormals.empty();
+
+      auto root = geomNode->skeletonRoot->nodeAs<Transform>();
+      bool motionBlur = root->motionBlur;
+      for (auto &joint : joints)
+        motionBlur |= joint->nodeAs<Transform>()->motionBlur;
+
       geomNode->skinnedEndPositions.resize(geomNode->skinnedPositions.size());
       geomNode->skinnedEndNormals.resize(geomNode->skinnedNormals.size());
-      size_t weightIdx = 0;
-
-      // only worth with huge meshes:
-      // tasking::parallel_in_blocks_of<64>(geomNode->positions.size(),
-      // [&](size_t start, size_t end)
-      for (size_t i = 0; i < geomNode->positions.size(); ++i) {
-        affine3f xfm{zero};
-        affine3f endXfm{zero};
-        for (size_t j = 0; j < weightsPerVertex; ++j, ++weightIdx) {
-          const int idx = geomNode->joints[weightIdx];
-          // skinning matrix
-          xfm = xfm
-              + geomNode->weights[weightIdx]
-                  * joints[idx]->nodeAs<Transform>()->accumulatedXfm
-                  * inverseBindMatrices[idx];
-          endXfm = endXfm
-              + geomNode->weights[weightIdx]
-                  * joints[idx]->nodeAs<Transform>()->accumulatedEndXfm
-                  * inverseBindMatrices[idx];
-        }
-        // from gltf docu:
-        // final joint matrix = globalTransformOfNodeThatTheMeshIsAttachedTo^-1 * 
-        //                         globalTransformOfJointNode(j) *
-        //                         inverseBindMatrixForJoint(j)
-        xfm = rcp(geomNode->skeletonRoot->nodeAs<Transform>()->accumulatedXfm)
-            * xfm;
-        endXfm =
-            rcp(geomNode->skeletonRoot->nodeAs<Transform>()->accumulatedEndXfm)
-            * endXfm;
-        geomNode->skinnedPositions[i] = xfmPoint(xfm, geomNode->positions[i]);
-        geomNode->skinnedEndPositions[i] =
-            xfmPoint(endXfm, geomNode->positions[i]);
-        if (geomNode->skinnedNormals.size()) {
-          geomNode->skinnedNormals[i] = xfmNormal(xfm, geomNode->normals[i]);
-          geomNode->skinnedEndNormals[i] =
-              xfmNormal(endXfm, geomNode->normals[i]);
-        }
+
+      // Joint palette, once per frame instead of per vertex and weight.
+      // From glTF docu:
+      // final joint matrix = globalTransformOfNodeThatTheMeshIsAttachedTo^-1 *
+      //                         globalTransformOfJointNode(j) *
+      //                         inverseBindMatrixForJoint(j)
+      // The weights sum up to one, so the first factor can go in already.
+      std::vector<affine3f> palette(joints.size());
+      std::vector<affine3f> endPalette(motionBlur ? joints.size() : 0);
+      const affine3f rootInv = rcp(root->accumulatedXfm);
+      const affine3f rootEndInv = rcp(root->accumulatedEndXfm);
+      for (size_t j = 0; j < joints.size(); ++j) {
+        auto joint = joints[j]->nodeAs<Transform>();
+        palette[j] = rootInv * joint->accumulatedXfm * inverseBindMatrices[j];
+        if (motionBlur)
+          endPalette[j] =
+              rootEndInv * joint->accumulatedEndXfm * inverseBindMatrices[j];
       }
 
-      bool motionBlur = geomNode->skeletonRoot->nodeAs<Transform>()->motionBlur;
-      for (auto idx : geomNode->joints)
-        motionBlur |= joints[idx]->nodeAs<Transform>()->motionBlur;
+      tasking::parallel_in_blocks_of<1024>(
+          numVertices, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+              const size_t w = i * weightsPerVertex;
+              const uint16_t *vertexJoints = &geomNode->joints[w];
+              const float *vertexWeights = &geomNode->weights[w];
+
+              const affine3f xfm = blendJoints(
+                  palette.data(), vertexJoints, vertexWeights, weightsPerVertex);
+              geomNode->skinnedPositions[i] =
+                  xfmPoint(xfm, geomNode->positions[i]);
+              if (hasNormals)
+                geomNode->skinnedNormals[i] =
+                    xfmNormal(xfm, geomNode->normals[i]);
+
+              if (!motionBlur)
+                continue;
+
+              const affine3f endXfm = blendJoints(endPalette.data(),
+                  vertexJoints,
+                  vertexWeights,
+                  weightsPerVertex);
+              geomNode->skinnedEndPositions[i] =
+                  xfmPoint(endXfm, geomNode->positions[i]);
+              if (hasNormals)
+                geomNode->skinnedEndNormals[i] =
+                    xfmNormal(endXfm, geomNode->normals[i]);
+            }
+          });
 
       auto &geom = geomNode->valueAs<cpp::Geometry>();
       if (motionBlur) {
@@ -362,10 +462,8 @@ namespace ospray {
     if (geomNode->group)
       groups.emplace(std::make_pair(geomHandle, *geomNode->group));
 
-    auto ospGeometricModel = geomNode->model->handle();
-    if (geomSGIdMap && sgGeomId)
-      geomSGIdMap->emplace(OSPGeomModelSGIdMap::value_type(
-          std::make_pair(ospGeometricModel, sgGeomId)));
+    if (geomNode->model)
+      registerModel(node, geomNode->model->handle());
   }
 
   inline void RenderScene::createVolume(Node &node)
@@ -422,29 +520,45 @@ namespace ospray {
 
   inline void RenderScene::createInstanceFromGroup(Node &node)
   {
-    auto setInstance = [&](auto group) {
-      group.setParam(
-          "dynamicScene", node.child("dynamicScene").valueAs<bool>());
-      group.setParam("compactMode", node.child("compactMode").valueAs<bool>());
-      group.setParam("robustMode", node.child("robustMode").valueAs<bool>());
+    if (incremental) {
+      updateInstances(node);
+      return;
+    }
 
-      cpp::Instance inst(group);
-      if (xfmsDiverged.top()) { // motion blur
-        std::vector<affine3f> motionXfms;
-        motionXfms.push_back(xfms.top());
-        motionXfms.push_back(endXfms.top());
-        inst.setParam("motion.transform", cpp::CopiedData(motionXfms));
-      } else
-        inst.setParam("transform", xfms.top());
-      inst.commit();
-      instances.push_back(inst);
+    // Instances are cached per node, for in place updates
+    if (cache && cache->entries.count(node.uniqueID()))
+      cacheValid = false; // reached through several paths
+
+    auto setInstance = [&](cpp::Group &group) {
+      setGroupParams(node, group);
+
+      // The instance of the last build is still good for the same group
+      cpp::Instance inst;
+      auto prev = previousEntries.find(node.uniqueID());
+      if (prev != previousEntries.end()) {
+        auto &prevEntries = prev->second;
+        auto match = std::find_if(prevEntries.begin(),
+            prevEntries.end(),
+            [&](const InstanceCache::Entry &e) {
+              return e.group.handle() == group.handle();
+            });
+        if (match != prevEntries.end()) {
+          inst = match->instance;
+          prevEntries.erase(match);
+          if (xfmsChanged.top())
+            setInstanceTransform(inst);
+        }
+      }
 
-      // sg picking
-      if (instSGIdMap && sgInstId) {
-        auto ospInstance = inst.handle();
-        instSGIdMap->emplace(OSPInstanceSGIdMap::value_type(
-            std::make_pair(ospInstance, sgInstId)));
+      if (!inst.handle()) {
+        inst = cpp::Instance(group);
+        setInstanceTransform(inst);
       }
+
+      registerInstance(node, inst);
+      if (cache)
+        cache->entries[node.uniqueID()].push_back({group, inst, instances.size()});
+      instances.push_back(inst);
     };
 
     if (node.hasChildOfType(NodeType::GEOMETRY)) {
@@ -462,6 +576,8 @@ namespace ospray {
       }
     }
 
+    // NOTE: volume groups are recreated by every traversal, so scenes with
+    //       volumes are always rebuilt
     if (node.hasChildOfType(NodeType::VOLUME)) {
       auto &volChildren = node.childrenOfType(NodeType::VOLUME);
       for (auto vol : volChildren) {
@@ -469,6 +585,7 @@ namespace ospray {
         if (groups.find(volHandle) != groups.end()) {
           auto &group = groups[volHandle];
           setInstance(group);
+          cacheValid = false;
         }
       }
     }
@@ -482,6 +599,7 @@ namespace ospray {
           if (groups.find(volHandle) != groups.end()) {
             auto &group = groups[volHandle];
             setInstance(group);
+            cacheValid = false;
           }
         }
       }
@@ -494,10 +612,231 @@ namespace ospray {
 
   inline void RenderScene::placeInstancesInWorld()
   {
-    if (!instances.empty())
-      world.setParam("instance", cpp::CopiedData(instances));
-    else
+    // Updated in place, replaced instances were patched into the array
+    if (incremental)
+      return;
+
+    if (!instances.empty()) {
+      cache->instanceData = cpp::CopiedData(instances);
+      world.setParam("instance", cache->instanceData);
+    } else {
+      cache->instanceData = cpp::CopiedData();
       world.removeParam("instance");
+    }
+
+    cache->instances.swap(instances);
+  }
+
+  inline void RenderScene::setGroupParams(Node &node, cpp::Group &group)
+  {
+    group.setParam("dynamicScene", node.child("dynamicScene").valueAs<bool>());
+    group.setParam("compactMode", node.child("compactMode").valueAs<bool>());
+    group.setParam("robustMode", node.child("robustMode").valueAs<bool>());
+  }
+
+  inline void RenderScene::setInstanceTransform(cpp::Instance &inst)
+  {
+    if (xfmsDiverged.top()) { // motion blur
+      std::vector<affine3f> motionXfms;
+      motionXfms.push_back(xfms.top());
+      motionXfms.push_back(endXfms.top());
+      inst.removeParam("transform");
+      inst.setParam("motion.transform", cpp::CopiedData(motionXfms));
+    } else {
+      inst.removeParam("motion.transform");
+      inst.setParam("transform", xfms.top());
+    }
+    inst.commit();
+  }
+
+  // Picking //////////////////////////////////////////////////////////////////
+
+  // The maps are only written for new OSPRay objects, and for changed SG ids
+  inline void RenderScene::registerInstance(Node &node, cpp::Instance &inst)
+  {
+    if (!instSGIdMap)
+      return;
+
+    auto &id = (*instSGIdMap)[inst.handle()];
+    id.sgId = sgInstId;
+    if (id.node.expired())
+      id.node = node.shared_from_this();
+  }
+
+  inline void RenderScene::registerModel(Node &node, OSPGeometricModel model)
+  {
+    if (!geomSGIdMap || !cache)
+      return;
+
+    // Geometries replace their model when recommitted
+    OSPGeometricModel previous = nullptr;
+    auto prev = previousModels.find(node.uniqueID());
+    if (prev != previousModels.end()) {
+      previous = prev->second;
+      previousModels.erase(prev);
+    } else {
+      auto cur = cache->models.find(node.uniqueID());
+      if (cur != cache->models.end())
+        previous = cur->second;
+    }
+
+    if (previous && previous != model) {
+      // The released handle may already be reused by another geometry
+      auto *id = geomSGIdMap->find(previous);
+      if (id && (id->node.expired() || id->node.lock().get() == &node))
+        geomSGIdMap->erase(previous);
+    }
+
+    cache->models[node.uniqueID()] = model;
+    auto &id = (*geomSGIdMap)[model];
+    id.sgId = sgGeomId;
+    if (previous != model || id.node.expired())
+      id.node = node.shared_from_this();
+  }
+
+  // Only the first world to reach a node gives it ids
+  inline unsigned int RenderScene::assignPickId(
+      Transform &xfm, unsigned int &id)
+  {
+    if (!id && pickIds) {
+      id = pickIds->allocate();
+      xfm.pickIds = pickIds;
+    }
+    return id;
+  }
+
+  // After a full rebuild, forgets whatever the last one had and this one
+  // didn't take over
+  inline void RenderScene::releaseUnused()
+  {
+    for (auto &prev : previousEntries) {
+      for (auto &entry : prev.second)
+        if (instSGIdMap)
+          instSGIdMap->erase(entry.instance.handle());
+    }
+
+    for (auto &prev : previousModels) {
+      auto *id = geomSGIdMap ? geomSGIdMap->find(prev.second) : nullptr;
+      if (!id)
+        continue;
+      auto owner = id->node.lock();
+      if (!owner || owner->uniqueID() == prev.first)
+        geomSGIdMap->erase(prev.second);
+    }
+
+    previousEntries.clear();
+    previousModels.clear();
+  }
+
+  // Incremental updates //////////////////////////////////////////////////////
+
+  // Changed nodes, and everything below a moved transform, are visited.  Other
+  // subtrees are skipped, keeping their instances as they are.  Changes of
+  // anything but a parameter value, or a transform's own value, may be
+  // structural (ie. added or removed children) and abandon the update for a
+  // full rebuild.
+  inline bool RenderScene::skipSubtree(Node &node)
+  {
+    if (abandoned)
+      return true;
+
+    const size_t lastBuild = cache->lastBuild;
+    const bool modified = node.lastModified() > lastBuild;
+    if (modified && node.type() != NodeType::PARAMETER) {
+      // Moved like by its translation, rotation or scale, if it has the same
+      // children as in the last build
+      if (node.type() == NodeType::TRANSFORM) {
+        auto itr = cache->children.find(node.uniqueID());
+        if (itr != cache->children.end() && itr->second == childrenHash(node))
+          return false;
+      }
+      abandoned = true;
+      return true;
+    }
+
+    return !modified && !xfmsChanged.top()
+        && node.childrenLastModified() <= lastBuild;
+  }
+
+  inline uint64_t RenderScene::childrenHash(Node &node)
+  {
+    // FNV-1a over the children's ids, in order
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (auto &c : node.children())
+      h = (h ^ c.second->uniqueID()) * 0x100000001b3ull;
+    return h;
+  }
+
+  inline void RenderScene::updateInstances(Node &node)
+  {
+    if (node.hasChildOfType(NodeType::VOLUME)
+        || node.hasChildOfType(NodeType::TRANSFER_FUNCTION)) {
+      abandoned = true;
+      return;
+    }
+
+    // Unlike createInstanceFromGroup(), unchanged geometries may have been
+    // skipped, so use their groups directly
+    std::vector<cpp::Group> nodeGroups;
+    if (node.hasChildOfType(NodeType::GEOMETRY)) {
+      for (auto geom : node.childrenOfType(NodeType::GEOMETRY)) {
+        auto &group = geom->nodeAs<Geometry>()->group;
+        if (group)
+          nodeGroups.push_back(*group);
+      }
+    }
+
+    auto itr = cache->entries.find(node.uniqueID());
+    const size_t numCached =
+        itr == cache->entries.end() ? 0 : itr->second.size();
+    if (nodeGroups.size() != numCached) {
+      abandoned = true;
+      return;
+    }
+
+    for (size_t i = 0; i < numCached; i++) {
+      auto &entry = itr->second[i];
+      auto &group = nodeGroups[i];
+
+      if (entry.group.handle() == group.handle()) {
+        if (xfmsChanged.top())
+          setInstanceTransform(entry.instance);
+        registerInstance(node, entry.instance);
+        continue;
+      }
+
+      // Recommitted geometries have a new group, which needs a new instance
+      setGroupParams(node, group);
+      cpp::Instance inst(group);
+      setInstanceTransform(inst);
+
+      if (instSGIdMap)
+        instSGIdMap->erase(entry.instance.handle());
+      registerInstance(node, inst);
+
+      // Only this slot of the world's array changes, OSPRay keeps the
+      // reference counts of the instances in it right
+      ospCopyData(cpp::SharedData(inst).handle(),
+          cache->instanceData.handle(),
+          entry.slot);
+      cache->instances[entry.slot] = inst;
+      entry.group = group;
+      entry.instance = inst;
+    }
+  }
+
+  inline void RenderScene::updateGroupedLight(Node &node)
+  {
+    auto itr = cache->entries.find(node.uniqueID());
+    if (itr == cache->entries.end() || itr->second.size() != 1) {
+      abandoned = true;
+      return;
+    }
+
+    auto &entry = itr->second.front();
+    entry.group.setParam("light", cpp::CopiedData(node.valueAs<cpp::Light>()));
+    entry.group.commit();
+    setInstanceTransform(entry.instance);
   }
 
   }  // namespace sg